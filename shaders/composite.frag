@@ -0,0 +1,11 @@
+#version 330 core
+out vec4 FragColor; // Output color for the pixel
+
+// the cached picture, the same size as the viewport
+uniform sampler2D layer;
+
+void main()
+{
+    // pixel for pixel, no filtering
+    FragColor = texelFetch(layer, ivec2(gl_FragCoord.xy), 0);
+}
@@ -0,0 +1,56 @@
+#version 330 core
+out vec4 FragColor; // Output color for the pixel
+
+uniform float halfWidth;
+
+flat in vec2 p0;
+flat in vec2 p1;
+flat in vec2 p2;
+flat in vec2 p3;
+
+// coarse samples to find the right basin, then Newton steps polish the closest one
+const int SAMPLES = 12;
+const int NEWTON_ITERATIONS = 4;
+
+vec2 bezier(float t)
+{
+    float u = 1.0 - t;
+    return u * u * u * p0 + 3.0 * u * u * t * p1 + 3.0 * u * t * t * p2 + t * t * t * p3;
+}
+
+void main()
+{
+    vec2 p = gl_FragCoord.xy;
+    float bestT = 0.0;
+    float best = 1e30;
+    for (int i = 0; i <= SAMPLES; i++)
+    {
+        float t = float(i) / float(SAMPLES);
+        vec2 d = bezier(t) - p;
+        float d2 = dot(d, d);
+        if (d2 < best)
+        {
+            best = d2;
+            bestT = t;
+        }
+    }
+    // minimize |B(t) - p|^2 with Newton steps on (B(t) - p) . B'(t) = 0
+    float t = bestT;
+    for (int i = 0; i < NEWTON_ITERATIONS; i++)
+    {
+        float u = 1.0 - t;
+        vec2 d = bezier(t) - p;
+        vec2 d1 = 3.0 * (u * u * (p1 - p0) + 2.0 * u * t * (p2 - p1) + t * t * (p3 - p2));
+        vec2 d2 = 6.0 * (u * (p2 - 2.0 * p1 + p0) + t * (p3 - 2.0 * p2 + p1));
+        float f = dot(d, d1);
+        float df = dot(d1, d1) + dot(d, d2);
+        if (df <= 1e-6) break;
+        t = clamp(t - f / df, 0.0, 1.0);
+    }
+    vec2 d = bezier(t) - p;
+    float dist = sqrt(min(dot(d, d), best));
+    // a pixel wide ramp at the edge
+    float coverage = clamp(halfWidth + 0.5 - dist, 0.0, 1.0);
+    if (coverage <= 0.0) discard;
+    FragColor = vec4(0.0, 0.0, 1.0, coverage);
+}
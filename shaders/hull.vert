@@ -0,0 +1,37 @@
+#version 330 core
+// One instance per cubic Bezier segment, drawn as the 4 vertex box around its control points
+layout (location = 0) in vec2 aP0;
+layout (location = 1) in vec2 aP1;
+layout (location = 2) in vec2 aP2;
+layout (location = 3) in vec2 aP3;
+
+uniform mat4 projection;
+// framebuffer size in pixels
+uniform vec2 viewport;
+uniform float halfWidth;
+
+// control points in window coordinates, the curve is evaluated per fragment
+flat out vec2 p0;
+flat out vec2 p1;
+flat out vec2 p2;
+flat out vec2 p3;
+
+vec2 toWindow(vec2 p)
+{
+    vec4 clip = projection * vec4(p, 0.0, 1.0);
+    return (clip.xy * 0.5 + 0.5) * viewport;
+}
+
+void main()
+{
+    p0 = toWindow(aP0);
+    p1 = toWindow(aP1);
+    p2 = toWindow(aP2);
+    p3 = toWindow(aP3);
+    // the curve stays inside the hull of its control points, grown by the stroke and one pixel for the edge
+    float extent = halfWidth + 1.0;
+    vec2 lo = min(min(p0, p1), min(p2, p3)) - extent;
+    vec2 hi = max(max(p0, p1), max(p2, p3)) + extent;
+    vec2 pos = vec2((gl_VertexID & 1) == 0 ? lo.x : hi.x, gl_VertexID < 2 ? lo.y : hi.y);
+    gl_Position = vec4(pos / viewport * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -3,9 +3,12 @@ layout (location = 0) in vec2 aPos; // Input vertex position (x, y)
 
 // Uniform for projection matrix (to handle different window aspect ratios)
 uniform mat4 projection;
+// Compact vertices are shorts read as integers: world = xy + zw * aPos. (0, 0, 1, 1) for float vertices.
+uniform vec4 dequantize;
 
 void main()
 {
+    vec2 pos = dequantize.xy + dequantize.zw * aPos;
     // Output position in clip space. z=0 for 2D, w=1.
-    gl_Position = projection * vec4(aPos.x, aPos.y, 0.0, 1.0);
-}
\ No newline at end of file
+    gl_Position = projection * vec4(pos.x, pos.y, 0.0, 1.0);
+}
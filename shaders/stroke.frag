@@ -0,0 +1,25 @@
+#version 330 core
+out vec4 FragColor; // Output color for the pixel
+
+uniform float halfWidth;
+
+flat in vec2 start;
+flat in vec2 end;
+flat in uint flags;
+
+void main()
+{
+    // distance of the pixel center to the segment. Joined ends are measured against the
+    // infinite line, the neighbouring quad takes over behind the miter, free ends get round caps
+    vec2 p = gl_FragCoord.xy;
+    vec2 segment = end - start;
+    float len2 = dot(segment, segment);
+    float t = len2 > 0.0 ? dot(p - start, segment) / len2 : 0.0;
+    if ((flags & 2u) == 0u) t = max(t, 0.0);
+    if ((flags & 4u) == 0u) t = min(t, 1.0);
+    float d = length(p - (start + t * segment));
+    // a pixel wide ramp at the edge
+    float coverage = clamp(halfWidth + 0.5 - d, 0.0, 1.0);
+    if (coverage <= 0.0) discard;
+    FragColor = vec4(0.0, 0.0, 1.0, coverage);
+}
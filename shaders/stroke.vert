@@ -0,0 +1,73 @@
+#version 330 core
+// One instance per polyline segment, drawn as a 4 vertex triangle strip
+layout (location = 0) in vec2 aPrev;
+layout (location = 1) in vec2 aStart;
+layout (location = 2) in vec2 aEnd;
+layout (location = 3) in vec2 aNext;
+// 1: segment exists, 2: aPrev belongs to the same strip, 4: aNext does
+layout (location = 4) in uint aFlags;
+
+uniform mat4 projection;
+uniform vec4 dequantize;
+// framebuffer size in pixels
+uniform vec2 viewport;
+uniform float halfWidth;
+
+// segment in window coordinates, the fragment shader measures the distance to it
+flat out vec2 start;
+flat out vec2 end;
+flat out uint flags;
+
+// miters longer than this many half widths are cut off
+const float MITER_LIMIT = 4.0;
+
+vec2 toWindow(vec2 p)
+{
+    vec4 clip = projection * vec4(dequantize.xy + dequantize.zw * p, 0.0, 1.0);
+    return (clip.xy * 0.5 + 0.5) * viewport;
+}
+
+vec2 direction(vec2 a, vec2 b)
+{
+    vec2 d = b - a;
+    float len = length(d);
+    return len > 1e-6 ? d / len : vec2(1.0, 0.0);
+}
+
+// offset of one corner of the quad, side is -1 or 1
+vec2 corner(vec2 dir, vec2 neighbourDir, bool joined, float side, float along, float extent)
+{
+    vec2 normal = vec2(-dir.y, dir.x);
+    if (!joined)
+        return extent * (side * normal + along * dir);
+    // the quads of two segments meet on the bisector of their normals
+    vec2 neighbourNormal = vec2(-neighbourDir.y, neighbourDir.x);
+    vec2 miter = normal + neighbourNormal;
+    float len = length(miter);
+    miter = len > 1e-6 ? miter / len : normal;
+    float scale = min(1.0 / max(dot(miter, normal), 1e-3), MITER_LIMIT);
+    return side * extent * scale * miter;
+}
+
+void main()
+{
+    flags = aFlags;
+    if ((aFlags & 1u) == 0u)
+    {
+        // the gap between two strips, nothing to draw
+        gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+    start = toWindow(aStart);
+    end = toWindow(aEnd);
+    vec2 dir = direction(start, end);
+    // one extra pixel for the anti-aliased edge
+    float extent = halfWidth + 1.0;
+    float side = (gl_VertexID & 1) == 0 ? -1.0 : 1.0;
+    vec2 pos;
+    if (gl_VertexID < 2)
+        pos = start + corner(dir, direction(toWindow(aPrev), start), (aFlags & 2u) != 0u, side, -1.0, extent);
+    else
+        pos = end + corner(dir, direction(end, toWindow(aNext)), (aFlags & 4u) != 0u, side, 1.0, extent);
+    gl_Position = vec4(pos / viewport * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,47 @@
+#include "alloc_counter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef DEBUG
+namespace
+{
+    thread_local size_t allocations = 0;
+}
+
+// the nothrow versions forward to these by default
+void* operator new(size_t size)
+{
+    allocations++;
+    void* p = std::malloc(size ? size : 1);
+    if (p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+#endif
+
+namespace curves
+{
+    size_t allocationCount()
+    {
+#ifdef DEBUG
+        return allocations;
+#else
+        return 0;
+#endif
+    }
+}
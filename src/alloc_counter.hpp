@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+
+namespace curves
+{
+    // Number of global operator new calls the calling thread made so far. Only counted in DEBUG
+    // builds (where alloc_counter.cpp replaces operator new), release builds always report 0.
+    // Compare two readings around a frame to check that it didn't allocate, the encoder and
+    // rasterizer threads don't get in the way.
+    size_t allocationCount();
+}
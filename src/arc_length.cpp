@@ -0,0 +1,117 @@
+#include "arc_length.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace curves
+{
+    const int ARC_TABLE_STEPS = 16;
+    // 5 point Gauss-Legendre on [-1 : 1], exact for the polynomial part up to degree 9
+    const float GAUSS_NODES[5] = { 0.0f, -0.5384693101f, 0.5384693101f, -0.9061798459f, 0.9061798459f };
+    const float GAUSS_WEIGHTS[5] = { 0.5688888889f, 0.4786286705f, 0.4786286705f, 0.2369268851f, 0.2369268851f };
+    // refinement steps of locate after the linear guess inside a table interval
+    const int LOCATE_NEWTON_STEPS = 2;
+
+    namespace
+    {
+        float speed(const float* c, float t)
+        {
+            float u = 1 - t;
+            float dx = 3 * (u * u * (c[2] - c[0]) + 2 * u * t * (c[4] - c[2]) + t * t * (c[6] - c[4]));
+            float dy = 3 * (u * u * (c[3] - c[1]) + 2 * u * t * (c[5] - c[3]) + t * t * (c[7] - c[5]));
+            return std::sqrt(dx * dx + dy * dy);
+        }
+    }
+
+    ArcLengthTable::ArcLengthTable()
+    {
+        segments = 0;
+        cumulative.assign(1, 0.0f);
+    }
+
+    void ArcLengthTable::build(const float* points, int pointCount)
+    {
+        segments = pointCount >= 4 ? (pointCount - 1) / 3 : 0;
+        cumulative.resize(segments * ARC_TABLE_STEPS + 1);
+        cumulative[0] = 0.0f;
+        for (int segment = 0; segment < segments; segment++)
+        {
+            const float* c = &points[6 * segment];
+            for (int step = 0; step < ARC_TABLE_STEPS; step++)
+            {
+                int k = segment * ARC_TABLE_STEPS + step;
+                cumulative[k + 1] = cumulative[k] + integrate(c, (float)step / ARC_TABLE_STEPS, (float)(step + 1) / ARC_TABLE_STEPS);
+            }
+        }
+    }
+
+    int ArcLengthTable::segment_count() const
+    {
+        return segments;
+    }
+
+    float ArcLengthTable::length() const
+    {
+        return cumulative.back();
+    }
+
+    float ArcLengthTable::distance_at(const float* points, int segment, float t) const
+    {
+        if (segments == 0) return 0.0f;
+        t = std::min(std::max(t, 0.0f), 1.0f);
+        int step = std::min((int)(t * ARC_TABLE_STEPS), ARC_TABLE_STEPS - 1);
+        float start = (float)step / ARC_TABLE_STEPS;
+        return cumulative[segment * ARC_TABLE_STEPS + step] + integrate(&points[6 * segment], start, t);
+    }
+
+    void ArcLengthTable::locate(const float* points, float distance, int& segment, float& t) const
+    {
+        if (segments == 0)
+        {
+            segment = 0;
+            t = 0.0f;
+            return;
+        }
+        distance = std::min(std::max(distance, 0.0f), length());
+        int k = std::upper_bound(cumulative.begin(), cumulative.end(), distance) - cumulative.begin() - 1;
+        k = std::min(std::max(k, 0), segments * ARC_TABLE_STEPS - 1);
+        segment = k / ARC_TABLE_STEPS;
+        float t0 = (float)(k % ARC_TABLE_STEPS) / ARC_TABLE_STEPS;
+        float t1 = t0 + 1.0f / ARC_TABLE_STEPS;
+        // the length is close to linear in t inside one interval, Newton on the exact length does the rest
+        float span = cumulative[k + 1] - cumulative[k];
+        t = span > 0.0f ? t0 + (t1 - t0) * (distance - cumulative[k]) / span : t0;
+        const float* c = &points[6 * segment];
+        for (int i = 0; i < LOCATE_NEWTON_STEPS; i++)
+        {
+            float v = speed(c, t);
+            if (v <= 0.0f) break;
+            float error = cumulative[k] + integrate(c, t0, t) - distance;
+            t = std::min(std::max(t - error / v, t0), t1);
+        }
+    }
+
+    void ArcLengthTable::sample_even(const float* points, float s0, float s1, int numPoints, float* out) const
+    {
+        for (int i = 0; i <= numPoints; i++)
+        {
+            int segment;
+            float t;
+            locate(points, s0 + (s1 - s0) * i / std::max(numPoints, 1), segment, t);
+            const float* c = &points[6 * segment];
+            float u = 1 - t;
+            out[2 * i] = u * u * u * c[0] + 3 * u * u * t * c[2] + 3 * u * t * t * c[4] + t * t * t * c[6];
+            out[2 * i + 1] = u * u * u * c[1] + 3 * u * u * t * c[3] + 3 * u * t * t * c[5] + t * t * t * c[7];
+        }
+    }
+
+    float ArcLengthTable::integrate(const float* controls, float t0, float t1)
+    {
+        float half = 0.5f * (t1 - t0);
+        float mid = 0.5f * (t0 + t1);
+        float sum = 0.0f;
+        for (int i = 0; i < 5; i++)
+            sum += GAUSS_WEIGHTS[i] * speed(controls, mid + half * GAUSS_NODES[i]);
+        return sum * half;
+    }
+}
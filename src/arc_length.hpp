@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+namespace curves
+{
+    // Cumulative arc length of a piecewise cubic Bezier curve (consecutive segments share
+    // their end points), tabulated ARC_TABLE_STEPS times per segment with Gauss-Legendre
+    // quadrature. The table only depends on the control points, so it can be kept until they move.
+    class ArcLengthTable
+    {
+    public:
+        ArcLengthTable();
+        void build(const float* points, int pointCount);
+        int segment_count() const;
+        float length() const;
+        // distance along the curve from its start to t in segment
+        float distance_at(const float* points, int segment, float t) const;
+        // inverse of distance_at, O(log n) in the table size
+        void locate(const float* points, float distance, int& segment, float& t) const;
+        // numPoints + 1 vertices spaced evenly between the distances s0 and s1
+        void sample_even(const float* points, float s0, float s1, int numPoints, float* out) const;
+    private:
+        // length of segment between t0 and t1
+        static float integrate(const float* controls, float t0, float t1);
+        int segments;
+        // cumulative length at the start of every table interval, one extra entry for the end
+        std::vector<float> cumulative;
+    };
+}
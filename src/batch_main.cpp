@@ -0,0 +1,598 @@
+// Windowless tessellation: control points in, line strip vertices out.
+//
+// Input formats
+//   text    one "x y" (or "x,y") point per line, an empty line ends a curve
+//   binary  little-endian float32 x, y pairs, a NaN pair ends a curve
+//   scene   binary scene file (see scene_file.hpp), mapped instead of read
+//   svg     SVG paths, see svg_import.hpp
+// Scene and SVG input can be written back out as a scene file with --save-scene.
+// Every text/binary curve is a piecewise cubic Bezier: P0 P1 P2 P3 [P4 P5 P6 ...].
+// Scenes can also hold Lagrange, spline and NURBS curves, --samples counts per NURBS span.
+//
+// Output formats
+//   binary  float32 x, y pairs per vertex, a NaN pair after every curve
+//   csv     "curve,x,y" lines
+//
+// Text and binary input are streamed, so only one chunk of points is held at a time.
+//
+// --image also draws the vertices as anti-aliased strokes into a PNG (or PAM) with the software
+// rasterizer, fitted to the drawing. The vertices are only written then if --output asks for them.
+
+#include "curves.hpp"
+#include "draw_list.hpp"
+#include "image_file.hpp"
+#include "nurbs.hpp"
+#include "scene_file.hpp"
+#include "soft_raster.hpp"
+#include "svg_import.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace
+{
+    const int DEFAULT_SAMPLES = 100;
+    const size_t DEFAULT_CHUNK_POINTS = 1 << 20;
+    const size_t OUTPUT_BUFFER_BYTES = 1 << 20;
+    const int DEFAULT_IMAGE_SIZE = 256;
+    // like the viewer's wide strokes
+    const float DEFAULT_STROKE_PIXELS = 3.0f;
+    // empty border around the drawing, as a fraction of the image
+    const float IMAGE_MARGIN = 0.05f;
+    // --tolerance on Lagrange curves: how finely they are probed, and the most samples they get
+    const int LAGRANGE_PROBE_SAMPLES_PER_NODE = 16;
+    const int MAX_LAGRANGE_SAMPLES = 16384;
+
+    enum class InputFormat
+    {
+        Guess,
+        Text,
+        Binary,
+        Scene,
+        Svg
+    };
+
+    struct Options
+    {
+        std::string input;
+        std::string output;
+        InputFormat format;
+        bool csv;
+        int samples;
+        // > 0 switches to adaptive sampling, in world units
+        float tolerance;
+        size_t chunkPoints;
+        // scene and SVG input are saved here as a scene file if not empty
+        std::string saveScene;
+        // rendered to this image if not empty
+        std::string image;
+        int imageWidth, imageHeight;
+        float strokePixels;
+        // 0 for one per core
+        int threads;
+    };
+
+    // buffered writer for stdout or a file, after a failed write everything else is dropped
+    // and close reports the failure
+    class Output
+    {
+    public:
+        Output() : file(NULL), discarding(false), failed(false), bytes(0)
+        {
+            buffer.reserve(OUTPUT_BUFFER_BYTES);
+        }
+
+        bool open(const std::string& path)
+        {
+            file = path.empty() || path == "-" ? stdout : std::fopen(path.c_str(), "wb");
+            return file != NULL;
+        }
+
+        // counts what is written and drops it
+        void discard()
+        {
+            discarding = true;
+        }
+
+        void write(const void* data, size_t size)
+        {
+            if (failed) return;
+            if (buffer.size() + size > OUTPUT_BUFFER_BYTES && !flush()) return;
+            const char* bytesIn = (const char*)data;
+            buffer.insert(buffer.end(), bytesIn, bytesIn + size);
+        }
+
+        bool flush()
+        {
+            if (!failed && !discarding && std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size())
+                failed = true;
+            if (!failed) bytes += buffer.size();
+            buffer.clear();
+            return !failed;
+        }
+
+        bool close()
+        {
+            bool ok = flush();
+            if (discarding) return ok;
+            if (file != stdout) ok = std::fclose(file) == 0 && ok;
+            else ok = std::fflush(stdout) == 0 && ok;
+            return ok;
+        }
+
+        bool has_failed() const
+        {
+            return failed;
+        }
+
+        size_t written() const
+        {
+            return bytes;
+        }
+    private:
+        std::FILE* file;
+        bool discarding;
+        // a write came up short (disk full, closed pipe)
+        bool failed;
+        std::vector<char> buffer;
+        size_t bytes;
+    };
+
+    // Turns a stream of control points into vertices. Cubics share their end points,
+    // so only the last point of the previous cubic has to be kept between chunks.
+    class CurveStreamer
+    {
+    public:
+        CurveStreamer(const Options& options, Output& out)
+            : options(options), out(out), windowSize(0), segmentWritten(false), curve(0), pointsIn(0), verticesOut(0), droppedPoints(0),
+            curveFirstVertex(0)
+        {
+        }
+
+        void add_point(float x, float y)
+        {
+            window[2 * windowSize] = x;
+            window[2 * windowSize + 1] = y;
+            windowSize++;
+            pointsIn++;
+            if (windowSize < 4) return;
+            bool first = !segmentWritten;
+            int samples = options.samples;
+            if (options.tolerance > 0.0f)
+                samples = curves::cubicSampleCount(window, 1.0f, options.tolerance);
+            vertices.resize(2 * (samples + 1));
+            curves::genCubicBezierCurve(samples, window, window + 2, window + 4, window + 6, vertices.data());
+            // every cubic after the first starts where the previous one ended
+            write_vertices(vertices.data() + (first ? 0 : 2), vertices.size() / 2 - (first ? 0 : 1));
+            segmentWritten = true;
+            window[0] = window[6];
+            window[1] = window[7];
+            windowSize = 1;
+        }
+
+        void end_curve()
+        {
+            // points that don't complete a cubic can't be drawn
+            if (!segmentWritten) droppedPoints += windowSize;
+            else droppedPoints += windowSize - 1;
+            if (segmentWritten) finish_curve();
+            windowSize = 0;
+            segmentWritten = false;
+        }
+
+        // curves that aren't streamed point by point, like the ones of a scene
+        void add_vertices(const std::vector<float>& vertices, size_t controlPoints)
+        {
+            pointsIn += controlPoints;
+            if (vertices.empty()) return;
+            write_vertices(vertices.data(), vertices.size() / 2);
+            finish_curve();
+        }
+
+        // every vertex and a strip per curve, only kept for --image
+        const std::vector<float>& kept_vertices() const
+        {
+            return kept;
+        }
+
+        const curves::DrawList& strips() const
+        {
+            return drawList;
+        }
+
+        // the output can't take more, reading on is pointless
+        bool failed() const
+        {
+            return out.has_failed();
+        }
+
+        void report(double seconds) const
+        {
+            double megabytes = out.written() / (1024.0 * 1024.0);
+            std::fprintf(stderr, "%zu control points, %zu curves -> %zu vertices (%.1f MB) in %.3f s, %.2f M points/s, %.1f MB/s\n",
+                pointsIn, curve, verticesOut, megabytes, seconds,
+                seconds > 0 ? pointsIn / seconds / 1e6 : 0.0, seconds > 0 ? megabytes / seconds : 0.0);
+            if (droppedPoints > 0)
+                std::fprintf(stderr, "%zu trailing control points did not complete a cubic and were skipped\n", droppedPoints);
+        }
+    private:
+        void write_vertices(const float* vertices, size_t count)
+        {
+            verticesOut += count;
+            if (!options.image.empty()) kept.insert(kept.end(), vertices, vertices + 2 * count);
+            if (!options.csv)
+            {
+                out.write(vertices, count * 2 * sizeof(float));
+                return;
+            }
+            char line[64];
+            for (size_t i = 0; i < count; i++)
+            {
+                int length = std::snprintf(line, sizeof(line), "%zu,%.7g,%.7g\n", curve, vertices[2 * i], vertices[2 * i + 1]);
+                out.write(line, length);
+            }
+        }
+
+        void finish_curve()
+        {
+            if (!options.image.empty())
+            {
+                int end = kept.size() / 2;
+                drawList.add_strip(curves::DrawStyle::Curve, curve, curveFirstVertex, end - curveFirstVertex);
+                curveFirstVertex = end;
+            }
+            if (!options.csv)
+            {
+                const float separator[2] = { std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::quiet_NaN() };
+                out.write(separator, sizeof(separator));
+            }
+            curve++;
+        }
+
+        const Options& options;
+        Output& out;
+        float window[8];
+        int windowSize;
+        // samples of the current cubic, kept to reuse its memory
+        std::vector<float> vertices;
+        bool segmentWritten;
+        size_t curve;
+        size_t pointsIn;
+        size_t verticesOut;
+        size_t droppedPoints;
+        std::vector<float> kept;
+        curves::DrawList drawList;
+        int curveFirstVertex;
+    };
+
+    // draws the vertices fitted into the image, keeping their aspect ratio
+    bool renderImage(const Options& options, const std::vector<float>& vertices, const curves::DrawList& strips)
+    {
+        float minX = std::numeric_limits<float>::max(), minY = minX;
+        float maxX = -minX, maxY = -minX;
+        for (size_t i = 0; i + 1 < vertices.size(); i += 2)
+        {
+            minX = std::min(minX, vertices[i]);
+            maxX = std::max(maxX, vertices[i]);
+            minY = std::min(minY, vertices[i + 1]);
+            maxY = std::max(maxY, vertices[i + 1]);
+        }
+        if (vertices.empty()) minX = minY = maxX = maxY = 0.0f;
+        // world units to clip space, the larger side fills the image minus the margins
+        float inner = 1.0f - 2.0f * IMAGE_MARGIN;
+        float scale = std::min(inner * options.imageWidth / std::max(maxX - minX, 1e-6f),
+            inner * options.imageHeight / std::max(maxY - minY, 1e-6f));
+        float projection[16] = {};
+        projection[0] = 2.0f * scale / options.imageWidth;
+        projection[5] = 2.0f * scale / options.imageHeight;
+        projection[10] = projection[15] = 1.0f;
+        projection[12] = -projection[0] * 0.5f * (minX + maxX);
+        projection[13] = -projection[5] * 0.5f * (minY + maxY);
+
+        // the viewer's colors
+        curves::RasterStyle style = { 0.5f * options.strokePixels, { 0.0f, 0.0f, 1.0f, 1.0f }, { 0.1f, 0.1f, 0.1f, 1.0f } };
+        curves::SoftRasterizer rasterizer;
+        rasterizer.set_thread_count(options.threads);
+        std::vector<unsigned char> pixels;
+        rasterizer.render(vertices.data(), strips, projection, options.imageWidth, options.imageHeight, style, pixels);
+        size_t dot = options.image.rfind('.');
+        bool pam = dot != std::string::npos && options.image.compare(dot, std::string::npos, ".pam") == 0;
+        return curves::saveImage(options.image, pam ? curves::ImageFormat::Raw : curves::ImageFormat::Png,
+            options.imageWidth, options.imageHeight, pixels.data(), true);
+    }
+
+    bool streamText(std::FILE* in, CurveStreamer& streamer)
+    {
+        char line[256];
+        while (!streamer.failed() && std::fgets(line, sizeof(line), in) != NULL)
+        {
+            char* p = line;
+            while (*p == ' ' || *p == '\t') p++;
+            if (*p == '\n' || *p == '\r' || *p == '\0')
+            {
+                streamer.end_curve();
+                continue;
+            }
+            if (*p == '#') continue;
+            char* next;
+            float x = std::strtof(p, &next);
+            if (next == p) return false;
+            p = next;
+            while (*p == ' ' || *p == '\t' || *p == ',') p++;
+            float y = std::strtof(p, &next);
+            if (next == p) return false;
+            streamer.add_point(x, y);
+        }
+        streamer.end_curve();
+        return std::ferror(in) == 0;
+    }
+
+    bool streamBinary(std::FILE* in, CurveStreamer& streamer, size_t chunkPoints)
+    {
+        std::vector<float> chunk(2 * chunkPoints);
+        size_t read;
+        // a pair can be split over two reads, the odd float is carried over
+        size_t carried = 0;
+        while (!streamer.failed() && (read = std::fread(chunk.data() + carried, sizeof(float), chunk.size() - carried, in)) > 0)
+        {
+            size_t available = carried + read;
+            size_t pairs = available / 2;
+            for (size_t i = 0; i < pairs; i++)
+            {
+                float x = chunk[2 * i], y = chunk[2 * i + 1];
+                if (std::isnan(x) || std::isnan(y))
+                    streamer.end_curve();
+                else
+                    streamer.add_point(x, y);
+            }
+            carried = available % 2;
+            if (carried) chunk[0] = chunk[available - 1];
+        }
+        streamer.end_curve();
+        return std::ferror(in) == 0;
+    }
+
+    // Lagrange curves have no control polygon for Wang's formula. A probe sampling gives their
+    // second differences instead, and the chord error of a sampling shrinks with the square of its step.
+    int lagrangeSampleCount(const float* points, int count, float tolerance)
+    {
+        int probe = LAGRANGE_PROBE_SAMPLES_PER_NODE * std::max(count - 1, 1);
+        std::vector<float> curve = curves::genLagrangeCurve(probe, points, count);
+        float worst = 0.0f;
+        for (size_t i = 2; i + 3 < curve.size(); i += 2)
+        {
+            float dx = curve[i - 2] - 2.0f * curve[i] + curve[i + 2];
+            float dy = curve[i - 1] - 2.0f * curve[i + 1] + curve[i + 3];
+            worst = std::max(worst, std::sqrt(dx * dx + dy * dy));
+        }
+        // a step of h strays about h^2 |C''| / 8 from the curve, the probe's differences are h^2 |C''|
+        float samples = std::ceil(probe * std::sqrt(worst / (8.0f * tolerance)));
+        return (int)std::min(std::max(samples, 1.0f), (float)MAX_LAGRANGE_SAMPLES);
+    }
+
+    void tessellateScene(const curves::Scene& scene, const Options& options, CurveStreamer& streamer)
+    {
+        const curves::PointArray& points = scene.points();
+        std::vector<float> vertices;
+        for (int curve = 0; curve < scene.curve_count() && !streamer.failed(); curve++)
+        {
+            size_t first = scene.curve_first(curve);
+            size_t count = scene.curve_point_count(curve);
+            switch (scene.curve_type(curve))
+            {
+            case curves::CurveType::CubicBezier:
+                for (size_t i = 0; i < count; i++)
+                    streamer.add_point(points[2 * (first + i)], points[2 * (first + i) + 1]);
+                streamer.end_curve();
+                break;
+            case curves::CurveType::Lagrange:
+            {
+                int samples = options.samples;
+                if (options.tolerance > 0.0f)
+                    samples = lagrangeSampleCount(&points[2 * first], count, options.tolerance);
+                streamer.add_vertices(curves::genLagrangeCurve(samples, &points[2 * first], count), count);
+                break;
+            }
+            case curves::CurveType::CatmullRom:
+            case curves::CurveType::Centripetal:
+            case curves::CurveType::Cardinal:
+            {
+                // the splines go through the same path as the cubics
+                std::vector<float> controls = curves::splineToCubics(scene.curve_type(curve), &points[2 * first], count);
+                for (size_t i = 0; i < controls.size(); i += 2)
+                    streamer.add_point(controls[i], controls[i + 1]);
+                streamer.end_curve();
+                break;
+            }
+            case curves::CurveType::Nurbs:
+            {
+                curves::NurbsEvaluator nurbs;
+                nurbs.assign(scene.curve_nurbs(curve), &points[2 * first], count);
+                // every span is sampled like one cubic, neighbours share their end vertex
+                vertices.assign(2, 0.0f);
+                for (int span = 0; span < nurbs.span_count(); span++)
+                {
+                    int samples = options.samples;
+                    if (options.tolerance > 0.0f)
+                        samples = nurbs.span_sample_count(span, 1.0f, options.tolerance);
+                    size_t end = vertices.size();
+                    vertices.resize(end + 2 * samples);
+                    nurbs.sample_span(span, samples, &vertices[end - 2]);
+                }
+                streamer.add_vertices(vertices, count);
+                break;
+            }
+            }
+        }
+    }
+
+    InputFormat guessFormat(const std::string& path)
+    {
+        size_t dot = path.rfind('.');
+        std::string extension = dot == std::string::npos ? "" : path.substr(dot + 1);
+        if (extension == "svg" || extension == "SVG") return InputFormat::Svg;
+        if (extension == "oglc") return InputFormat::Scene;
+        if (extension == "bin" || extension == "f32") return InputFormat::Binary;
+        return InputFormat::Text;
+    }
+
+    void printUsage()
+    {
+        std::cerr << "usage: curve_batch [options] [input|-]\n"
+            << "  --format text|binary|scene|svg  input format (guessed from the extension, stdin is text)\n"
+            << "  --samples N                     samples per cubic, NURBS span or Lagrange curve (default " << DEFAULT_SAMPLES << ")\n"
+            << "  --tolerance T                   adaptive samples, max distance to the curve in world units\n"
+            << "  --output PATH                   write here instead of stdout\n"
+            << "  --csv                           write curve,x,y lines instead of float32 pairs\n"
+            << "  --chunk N                       points read per chunk of binary input (default " << DEFAULT_CHUNK_POINTS << ")\n"
+            << "  --save-scene PATH               also save scene or SVG input as a scene file\n"
+            << "  --image PATH                    draw the curves into a .png or .pam, vertices only go out with --output then\n"
+            << "  --size WxH                      image size (default " << DEFAULT_IMAGE_SIZE << "x" << DEFAULT_IMAGE_SIZE << ")\n"
+            << "  --stroke W                      stroke width in pixels (default " << DEFAULT_STROKE_PIXELS << ")\n"
+            << "  --threads N                     rasterizer threads, 0 for one per core (default 0)\n";
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options)
+    {
+        options.format = InputFormat::Guess;
+        options.csv = false;
+        options.samples = DEFAULT_SAMPLES;
+        options.tolerance = 0.0f;
+        options.chunkPoints = DEFAULT_CHUNK_POINTS;
+        options.imageWidth = options.imageHeight = DEFAULT_IMAGE_SIZE;
+        options.strokePixels = DEFAULT_STROKE_PIXELS;
+        options.threads = 0;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--format" && hasValue)
+            {
+                std::string format = argv[++i];
+                if (format == "text") options.format = InputFormat::Text;
+                else if (format == "binary") options.format = InputFormat::Binary;
+                else if (format == "scene") options.format = InputFormat::Scene;
+                else if (format == "svg") options.format = InputFormat::Svg;
+                else return false;
+            }
+            else if (arg == "--samples" && hasValue)
+                options.samples = std::atoi(argv[++i]);
+            else if (arg == "--tolerance" && hasValue)
+                options.tolerance = (float)std::atof(argv[++i]);
+            else if (arg == "--output" && hasValue)
+                options.output = argv[++i];
+            else if (arg == "--csv")
+                options.csv = true;
+            else if (arg == "--chunk" && hasValue)
+                options.chunkPoints = std::strtoul(argv[++i], NULL, 10);
+            else if (arg == "--save-scene" && hasValue)
+                options.saveScene = argv[++i];
+            else if (arg == "--image" && hasValue)
+                options.image = argv[++i];
+            else if (arg == "--size" && hasValue)
+            {
+                if (std::sscanf(argv[++i], "%dx%d", &options.imageWidth, &options.imageHeight) != 2) return false;
+            }
+            else if (arg == "--stroke" && hasValue)
+                options.strokePixels = (float)std::atof(argv[++i]);
+            else if (arg == "--threads" && hasValue)
+                options.threads = std::atoi(argv[++i]);
+            else if (arg.size() > 1 && arg[0] == '-' && arg != "-")
+                return false;
+            else
+                options.input = arg;
+        }
+        return options.samples > 0 && options.chunkPoints > 0 && options.imageWidth > 0 && options.imageHeight > 0
+            && options.strokePixels > 0.0f && options.threads >= 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+    bool fromStdin = options.input.empty() || options.input == "-";
+    if (options.format == InputFormat::Guess)
+        options.format = fromStdin ? InputFormat::Text : guessFormat(options.input);
+    if (fromStdin && (options.format == InputFormat::Scene || options.format == InputFormat::Svg))
+    {
+        std::cerr << "ERROR::BATCH::SCENE_AND_SVG_INPUT_NEED_A_FILE" << std::endl;
+        return 1;
+    }
+    if (!options.saveScene.empty() && options.format != InputFormat::Scene && options.format != InputFormat::Svg)
+    {
+        // text and binary input is streamed, there is no scene to save
+        std::cerr << "ERROR::BATCH::ONLY_SCENE_AND_SVG_INPUT_CAN_BE_SAVED" << std::endl;
+        return 1;
+    }
+
+#ifdef _WIN32
+    // keep the C runtime from translating line endings in binary streams
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    Output out;
+    if (!options.image.empty() && options.output.empty())
+        out.discard();
+    else if (!out.open(options.output))
+    {
+        std::cerr << "ERROR::BATCH::OUTPUT_NOT_SUCCESFULLY_OPENED: " << options.output << std::endl;
+        return 1;
+    }
+    CurveStreamer streamer(options, out);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    bool ok = true;
+    if (options.format == InputFormat::Scene || options.format == InputFormat::Svg)
+    {
+        curves::Scene scene;
+        ok = options.format == InputFormat::Scene ? curves::loadScene(options.input, scene) : curves::importSvg(options.input, scene);
+        if (ok) tessellateScene(scene, options, streamer);
+        if (ok && !options.saveScene.empty()) ok = curves::saveScene(options.saveScene, scene);
+    }
+    else
+    {
+        std::FILE* in = fromStdin ? stdin : std::fopen(options.input.c_str(), options.format == InputFormat::Binary ? "rb" : "r");
+        if (in == NULL)
+        {
+            std::cerr << "ERROR::BATCH::INPUT_NOT_SUCCESFULLY_OPENED: " << options.input << std::endl;
+            return 1;
+        }
+        ok = options.format == InputFormat::Binary ? streamBinary(in, streamer, options.chunkPoints) : streamText(in, streamer);
+        if (!ok) std::cerr << "ERROR::BATCH::MALFORMED_INPUT" << std::endl;
+        if (in != stdin) std::fclose(in);
+    }
+    if (!out.close())
+    {
+        std::cerr << "ERROR::BATCH::WRITE_FAILED" << std::endl;
+        ok = false;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    streamer.report(seconds);
+    if (ok && !options.image.empty())
+    {
+        start = std::chrono::steady_clock::now();
+        ok = renderImage(options, streamer.kept_vertices(), streamer.strips());
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::fprintf(stderr, "%dx%d image in %.3f s\n", options.imageWidth, options.imageHeight, seconds);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#include "camera.hpp"
+
+#include <algorithm>
+
+namespace curves
+{
+    // past this, float coordinates around 1 can't resolve single pixels anymore
+    const float MIN_ZOOM = 1e-3f;
+    const float MAX_ZOOM = 1e5f;
+
+    Camera::Camera()
+    {
+        centerX = centerY = 0.0f;
+        zoom = 1.0f;
+        width = height = 1;
+    }
+
+    void Camera::resize(int width, int height)
+    {
+        if (width <= 0 || height <= 0) return;
+        this->width = width;
+        this->height = height;
+    }
+
+    void Camera::pan(double dxPixels, double dyPixels)
+    {
+        // screen y points down, world y points up
+        centerX -= dxPixels * 2.0 / (zoom * width);
+        centerY += dyPixels * 2.0 / (zoom * height);
+    }
+
+    void Camera::zoom_at(double sx, double sy, float factor)
+    {
+        float beforeX, beforeY;
+        screen_to_world(sx, sy, beforeX, beforeY);
+        zoom = std::min(std::max(zoom * factor, MIN_ZOOM), MAX_ZOOM);
+        float afterX, afterY;
+        screen_to_world(sx, sy, afterX, afterY);
+        centerX += beforeX - afterX;
+        centerY += beforeY - afterY;
+    }
+
+    void Camera::screen_to_world(double sx, double sy, float& x, float& y) const
+    {
+        x = centerX + ((sx / width) - 0.5) * 2.0 / zoom;
+        y = centerY - ((sy / height) - 0.5) * 2.0 / zoom;
+    }
+
+    float Camera::pixel_size() const
+    {
+        return 2.0f / (zoom * width);
+    }
+
+    float Camera::pixels_per_unit() const
+    {
+        return 0.5f * zoom * std::max(width, height);
+    }
+
+    void Camera::bounds(float& left, float& right, float& bottom, float& top) const
+    {
+        left = centerX - 1.0f / zoom;
+        right = centerX + 1.0f / zoom;
+        bottom = centerY - 1.0f / zoom;
+        top = centerY + 1.0f / zoom;
+    }
+
+    void Camera::projection(float* matrix) const
+    {
+        float left, right, bottom, top;
+        bounds(left, right, bottom, top);
+        createOrthoProjection(matrix, left, right, bottom, top, -1.0f, 1.0f);
+    }
+
+    void createOrthoProjection(float* matrix, float left, float right, float bottom, float top, float nearVal, float farVal)
+    {
+        matrix[0] = 2.0f / (right - left);
+        matrix[4] = 0.0f;
+        matrix[8] = 0.0f;
+        matrix[12] = -(right + left) / (right - left);
+        matrix[1] = 0.0f;
+        matrix[5] = 2.0f / (top - bottom);
+        matrix[9] = 0.0f;
+        matrix[13] = -(top + bottom) / (top - bottom);
+        matrix[2] = 0.0f;
+        matrix[6] = 0.0f;
+        matrix[10] = -2.0f / (farVal - nearVal);
+        matrix[14] = -(farVal + nearVal) / (farVal - nearVal);
+        matrix[3] = 0.0f;
+        matrix[7] = 0.0f;
+        matrix[11] = 0.0f;
+        matrix[15] = 1.0f;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+namespace curves
+{
+    // Pan/zoom view onto the world. At zoom 1 the window shows [-1 : 1] on both axes.
+    class Camera
+    {
+    public:
+        Camera();
+        // size of the window in screen coordinates (the unit cursor positions are reported in)
+        void resize(int width, int height);
+        void pan(double dxPixels, double dyPixels);
+        // zooms by factor while keeping the world point under (sx, sy) in place
+        void zoom_at(double sx, double sy, float factor);
+        void screen_to_world(double sx, double sy, float& x, float& y) const;
+        // world units covered by one pixel along x
+        float pixel_size() const;
+        // pixels per world unit along the finer axis
+        float pixels_per_unit() const;
+        void bounds(float& left, float& right, float& bottom, float& top) const;
+        void projection(float* matrix) const;
+    private:
+        float centerX, centerY;
+        float zoom;
+        int width, height;
+    };
+
+    // Creates a matrix to map coordinates from world space to clip space (-1 to 1)
+    void createOrthoProjection(float* matrix, float left, float right, float bottom, float top, float nearVal, float farVal);
+}
@@ -1,78 +1,699 @@
 #include "curve_program.hpp"
+#include "scene_file.hpp"
+#include "svg_import.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <iostream>
 
 namespace curves
 {
+    // how close (in pixels) a click has to be to grab a control point
+    const float PICK_RADIUS_PIXELS = 10.0f;
+    // half the width of the point markers
+    const float CROSS_SIZE_PIXELS = 8.0f;
+    // how far the sampled line may stray from the real curve
+    const float LOD_TOLERANCE_PIXELS = 0.25f;
+    // each notch of the scroll wheel zooms by this factor
+    const float ZOOM_STEP = 1.1f;
+    // vertices per node interval of a Lagrange curve, within [MIN : MAX] per curve
+    const int LAGRANGE_SAMPLES_PER_NODE = 8;
+    const int MIN_LAGRANGE_SAMPLES = 100;
+    const int MAX_LAGRANGE_SAMPLES = 16384;
+    // largest distance between vertices when cubics are sampled by arc length
+    const float ARC_SPACING_PIXELS = 4.0f;
+
     CurveProgram::CurveProgram()
     {
         // --- Default Points for the cubic curve ---
         // coordinates centered around (0,0).
         // Each pair is an (x, y) point.
-        clicks = 0;
+        selected = -1;
+        indexDirty = false;
+        mouseHeld = false;
+        panning = false;
+        panX = panY = 0.0;
+        cursorX = cursorY = 0.0;
+        cursorTime = 0.0;
+        cursorDirty = false;
+        coalescedEvents = 0;
+        worstLatency = 0.0;
+        cubicHulls = false;
+        evenSpacing = false;
+        layerRevision = 0;
+        layerCurve = -1;
+        std::fill(layerView, layerView + 4, 0.0f);
+        layerHulls = layerEvenSpacing = false;
+        toleranceScale = layerToleranceScale = 1.0f;
+        allMarkers = layerAllMarkers = true;
+        // nothing made yet
+        staticRevision = layerRevision - 1;
+        staticCoords = staticHulls = 0;
         // default points (Cubic Bezier)
-        type = curves::CurveType::CubicBezier;
-        points = { { -0.8f, -0.5f }, { -0.4f, 0.5f }, { 0.0f, -0.5f }, { 0.4f, 0.5f } };
+        const float defaultPoints[] = { -0.8f, -0.5f, -0.4f, 0.5f, 0.0f, -0.5f, 0.4f, 0.5f };
+        scene.add_curve(curves::CurveType::CubicBezier, defaultPoints, 4);
+        activeCurve = 0;
+        rebuild_index();
         refresh_line();
     }
     
+    bool CurveProgram::load_scene(const std::string& path)
+    {
+        // SVG drawings are converted, everything else has to be a binary scene
+        bool svg = path.size() > 4 && (path.compare(path.size() - 4, 4, ".svg") == 0 || path.compare(path.size() - 4, 4, ".SVG") == 0);
+        Scene loaded;
+        if (svg ? !importSvg(path, loaded) : !loadScene(path, loaded)) return false;
+        scene = loaded;
+        // opening a file can't be undone
+        history.clear();
+        curveCaches.clear();
+        selected = -1;
+        activeCurve = scene.curve_count() > 0 ? 0 : -1;
+        layerRevision++;
+        // the picking structures are built on the first click, so opening stays cheap
+        indexDirty = true;
+        return true;
+    }
+    
+    bool CurveProgram::save_scene(const std::string& path) const
+    {
+        if (!saveScene(path, scene)) return false;
+#ifdef DEBUG
+        // the file has to read back as the same drawing
+        Scene saved;
+        bool same = loadScene(path, saved) && saved.get_types() == scene.get_types() && saved.get_offsets() == scene.get_offsets()
+            && std::equal(scene.points().data(), scene.points().data() + scene.points().size(), saved.points().data());
+        for (int curve = 0; same && curve < scene.curve_count(); curve++)
+        {
+            const NurbsData& a = scene.curve_nurbs(curve);
+            const NurbsData& b = saved.curve_nurbs(curve);
+            same = a.degree == b.degree && a.knots == b.knots && a.weights == b.weights;
+        }
+        if (!same) std::cerr << "ERROR::PROGRAM::SCENE_ROUND_TRIP_MISMATCH: " << path << std::endl;
+#endif
+        return true;
+    }
+
     void CurveProgram::press_mouse()
     {
         mouseHeld = true;
+        float x, y;
+        cursor_to_world(x, y);
+        // grab the control point under the cursor
+        if (indexDirty) rebuild_index();
+        history.begin();
+        float radius = PICK_RADIUS_PIXELS * camera.pixel_size();
+        selected = grid.nearest(x, y, radius);
+        if (selected < 0)
+        {
+            // clicking on a cubic splits it there and grabs the new point
+            CurveHit hit = bvh.nearest(scene.points().data(), x, y, radius);
+            if (hit.segment >= 0)
+                selected = insert_point(hit.segment, hit.t);
+        }
+        if (selected < 0 && activeCurve >= 0
+            && (scene.curve_type(activeCurve) == CurveType::Lagrange || isSpline(scene.curve_type(activeCurve))))
+        {
+            // clicking next to a curve through its points adds a new one
+            selected = scene.curve_first(activeCurve) + scene.curve_point_count(activeCurve);
+            float node[2] = { x, y };
+            history.insert(scene, activeCurve, selected, node, 1);
+            // nodes of the last curve don't shift any other point
+            if (selected + 1 == (int)scene.point_count())
+                grid.insert(selected, x, y);
+            else
+                rebuild_index();
+        }
+        if (selected >= 0)
+            activeCurve = scene.curve_of_point(selected);
+        // the cursor doesn't move the point until it moves itself
+        cursorDirty = false;
     }
     
     void CurveProgram::release_mouse()
     {
+        if (!mouseHeld) return;
         mouseHeld = false;
+        history.commit(scene);
 #ifdef DEBUG// print coordinates for current point on screen
-        std::vector<float> p = points.at(clicks);
-        std::string log_info = "P" + std::to_string(clicks) + ": " + std::to_string(p[0]) + " " + std::to_string(p[1]) + "\n";
-        std::fprintf(stdout, log_info.c_str());
+        if (selected >= 0)
+        {
+            const PointArray& points = scene.points();
+            std::string log_info = "P" + std::to_string(selected) + ": " + std::to_string(points[2 * selected]) + " " + std::to_string(points[2 * selected + 1])
+                + " (" + std::to_string(coalescedEvents) + " cursor events coalesced, up to "
+                + std::to_string(worstLatency * 1000.0) + " ms from event to frame)\n";
+            std::fprintf(stdout, "%s", log_info.c_str());
+        }
+        coalescedEvents = 0;
+        worstLatency = 0.0;
+#endif
+        selected = -1;
+    }
+    
+    void CurveProgram::press_pan()
+    {
+        panning = true;
+        panX = cursorX;
+        panY = cursorY;
+    }
+    
+    void CurveProgram::release_pan()
+    {
+        panning = false;
+    }
+    
+    void CurveProgram::scroll(double yoffset)
+    {
+        camera.zoom_at(cursorX, cursorY, std::pow(ZOOM_STEP, (float)yoffset));
+    }
+    
+    void CurveProgram::cursor_moved(double xpos, double ypos, double time)
+    {
+        // only remember the newest position, update_drag applies it once per frame
+        cursorX = xpos;
+        cursorY = ypos;
+        // the first event of a frame waits the longest
+        if (!cursorDirty) cursorTime = time;
+        cursorDirty = true;
+        if (mouseHeld) coalescedEvents++;
+    }
+    
+    void CurveProgram::resize_window(int width, int height)
+    {
+        camera.resize(width, height);
+    }
+    
+    void CurveProgram::update_drag(double time)
+    {
+        if (!cursorDirty) return;
+        cursorDirty = false;
+        if (panning)
+        {
+            camera.pan(cursorX - panX, cursorY - panY);
+            panX = cursorX;
+            panY = cursorY;
+        }
+        if (!mouseHeld || selected < 0) return;
+#ifdef DEBUG
+        worstLatency = std::max(worstLatency, time - cursorTime);
 #endif
-        // increment clicks to edit the next Point
-        switch (type)
+        float xpos, ypos;
+        cursor_to_world(xpos, ypos);
+        // override the values of the Point vector and keep the grid in sync
+        PointArray& points = scene.points();
+        history.touch(scene, selected);
+        float oldX = points[2 * selected];
+        float oldY = points[2 * selected + 1];
+        points[2 * selected] = xpos;
+        points[2 * selected + 1] = ypos;
+        point_moved(selected, oldX, oldY);
+    }
+    
+    void CurveProgram::undo()
+    {
+        apply_history(false);
+    }
+    
+    void CurveProgram::redo()
+    {
+        apply_history(true);
+    }
+    
+    void CurveProgram::apply_history(bool redo)
+    {
+        // the step of a drag isn't finished yet
+        if (mouseHeld) return;
+        bool structural;
+        if (!(redo ? history.redo(scene, historyChanges, structural) : history.undo(scene, historyChanges, structural))) return;
+        selected = -1;
+        if (activeCurve >= scene.curve_count()) activeCurve = scene.curve_count() - 1;
+        // any curve can be touched by a step
+        layerRevision++;
+        if (structural)
         {
-        case CurveType::CubicBezier:
-            clicks = (clicks + 1) % 4;
-            break;
-        case CurveType::Lagrange:
-            clicks++;
-            break;
+            // points were inserted or removed, the next click rebuilds the index
+            indexDirty = true;
+            invalidate_cache(-1);
+            return;
+        }
+        if (indexDirty)
+        {
+            invalidate_cache(-1);
+            return;
         }
+        for (const PointChange& change : historyChanges)
+            point_moved(change.point, change.oldX, change.oldY);
     }
     
-    void CurveProgram::update_drag(GLFWwindow* window)
+    void CurveProgram::new_curve(CurveType type)
     {
-        if (!mouseHeld || clicks >= points.size()) return;
-        // store x and y position of mouse cursor
-        double xpos, ypos;
-        glfwGetCursorPos(window, &xpos, &ypos);
-        // store x and y size of window
-        int xwindow, ywindow;
-        glfwGetWindowSize(window, &xwindow, &ywindow);
-        // adjust position for the projection [-1 : 1]
-        xpos = ((xpos / xwindow) - 0.5) * 2;
-        ypos = -((ypos / ywindow) - 0.5) * 2;
-        // override the values of the Point vector
-        points[clicks][0] = xpos;
-        points[clicks][1] = ypos;
+        scene.add_curve(type, NULL, 0);
+        activeCurve = scene.curve_count() - 1;
+        indexDirty = true;
+    }
+    
+    void CurveProgram::invalidate_cache(int curve)
+    {
+        for (int i = 0; i < (int)curveCaches.size(); i++)
+        {
+            if (curve >= 0 && i != curve) continue;
+            curveCaches[i].polynomialDirty = true;
+            curveCaches[i].arcLengthDirty = true;
+            curveCaches[i].splineDirty = true;
+            curveCaches[i].nurbsDirty = true;
+        }
+    }
+    
+    CurveProgram::CurveCache& CurveProgram::curve_cache(int curve)
+    {
+        if ((int)curveCaches.size() < scene.curve_count())
+        {
+            CurveCache empty;
+            empty.polynomialDirty = empty.arcLengthDirty = empty.splineDirty = empty.nurbsDirty = true;
+            empty.dirtyFirst = INT_MAX;
+            empty.dirtyLast = -1;
+            curveCaches.resize(scene.curve_count(), empty);
+        }
+        return curveCaches[curve];
+    }
+    
+    void CurveProgram::point_moved(int point, float oldX, float oldY)
+    {
+        const PointArray& points = scene.points();
+        grid.move(point, oldX, oldY, points[2 * point], points[2 * point + 1]);
+        int curve = scene.curve_of_point(point);
+        if (isSpline(scene.curve_type(curve)))
+        {
+            // a point shapes the two segments on each side of it, the rest of the curve stays
+            CurveCache& cached = curve_cache(curve);
+            int local = point - scene.curve_first(curve);
+            cached.dirtyFirst = std::min(cached.dirtyFirst, local - 2);
+            cached.dirtyLast = std::max(cached.dirtyLast, local + 1);
+            return;
+        }
+        if (scene.curve_type(curve) == CurveType::Nurbs)
+        {
+            // a NURBS point only changes the spans it belongs to
+            CurveCache& cached = curve_cache(curve);
+            if (!cached.nurbsDirty)
+                cached.nurbs.move_point(point - scene.curve_first(curve), points[2 * point], points[2 * point + 1]);
+            return;
+        }
+        invalidate_cache(curve);
+        if (scene.curve_type(curve) == CurveType::CubicBezier)
+        {
+            // segment ends are shared by two segments
+            int local = point - scene.curve_first(curve);
+            int segmentCount = (scene.curve_point_count(curve) - 1) / 3;
+            if (segmentCount <= 0) return;
+            int segment = firstSegment[curve] + std::min(local / 3, segmentCount - 1);
+            bvh.refit_segment(points.data(), segment);
+            if (local % 3 == 0 && local > 0 && local / 3 < segmentCount)
+                bvh.refit_segment(points.data(), segment - 1);
+        }
+    }
+    
+    int CurveProgram::insert_point(int segment, float t)
+    {
+        int start = segmentStarts[segment];
+        int curve = scene.curve_of_point(start);
+        history.touch(scene, start + 1);
+        history.touch(scene, start + 2);
+        float* c = &scene.points()[2 * start];
+        float left[8], right[8];
+        splitCubic(c, t, left, right);
+        // P0 L1 L2 P3 becomes P0 L1' L2' M R1 R2 P3
+        std::copy(left + 2, left + 6, c + 2);
+        history.insert(scene, curve, start + 3, right, 3);
+        rebuild_index();
+        return start + 3;
+    }
+    
+    void CurveProgram::rebuild_index()
+    {
+        grid.build(scene.points().data(), scene.point_count());
+        segmentStarts.clear();
+        firstSegment.assign(scene.curve_count(), 0);
+        for (int curve = 0; curve < scene.curve_count(); curve++)
+        {
+            firstSegment[curve] = segmentStarts.size();
+            if (scene.curve_type(curve) != CurveType::CubicBezier) continue;
+            // consecutive cubics share their end points
+            int first = scene.curve_first(curve);
+            int last = first + (int)scene.curve_point_count(curve) - 1;
+            for (int start = first; start + 3 <= last; start += 3)
+                segmentStarts.push_back(start);
+        }
+        bvh.build(scene.points().data(), segmentStarts);
+        indexDirty = false;
+    }
+    
+    void CurveProgram::cursor_to_world(float& x, float& y) const
+    {
+        camera.screen_to_world(cursorX, cursorY, x, y);
     }
     
     const std::vector<float>& CurveProgram::get_line_coords() const {
         return line_coords;
     }
     
+    const DrawList& CurveProgram::get_draw_list() const {
+        return drawList;
+    }
+    
+    void CurveProgram::set_cubic_hulls(bool enable) {
+        cubicHulls = enable;
+    }
+    
+    void CurveProgram::set_even_spacing(bool enable) {
+        evenSpacing = enable;
+    }
+    
+    void CurveProgram::set_quality(const QualityLevel& quality)
+    {
+        allMarkers = quality.allMarkers;
+        if (quality.toleranceScale == toleranceScale) return;
+        toleranceScale = quality.toleranceScale;
+        // the cached Lagrange and spline vertices were made for the old tolerance
+        for (CurveCache& cached : curveCaches)
+            cached.polynomialDirty = cached.splineDirty = true;
+    }
+    
+    const std::vector<float>& CurveProgram::get_hull_controls() const {
+        return hullControls;
+    }
+    
+    const std::vector<int>& CurveProgram::get_hull_curves() const {
+        return hullCurves;
+    }
+    
+    int CurveProgram::live_curve() const {
+        return activeCurve;
+    }
+    
+    unsigned CurveProgram::layer_revision() const {
+        return layerRevision;
+    }
+    
+    const Camera& CurveProgram::get_camera() const {
+        return camera;
+    }
+    
+    void CurveProgram::update_spline(int curve)
+    {
+        CurveCache& cached = curve_cache(curve);
+        const float* nodes = &scene.points()[2 * scene.curve_first(curve)];
+        int count = scene.curve_point_count(curve);
+        CurveType type = scene.curve_type(curve);
+        int segments = count - 1;
+        int known = (int)cached.splineOffsets.size() - 1;
+        float view[4];
+        camera.bounds(view[0], view[1], view[2], view[3]);
+        // the sample counts depend on the view, so panning or zooming resamples everything
+        bool rebuild = cached.splineDirty || segments < known || !std::equal(view, view + 4, cached.splineView);
+        if (rebuild)
+        {
+            cached.splineOffsets.assign(1, 0);
+            cached.vertices.resize(2);
+            std::copy(view, view + 4, cached.splineView);
+            cached.splineDirty = false;
+            cached.dirtyFirst = 0;
+            cached.dirtyLast = segments - 1;
+            known = 0;
+        }
+        if (segments <= 0)
+        {
+            // nothing to patch yet, the first segment starts over
+            cached.vertices.assign(nodes, nodes + 2 * count);
+            cached.splineDirty = true;
+            return;
+        }
+        if (segments > known)
+        {
+            // appended segments start out empty, the one that used to be the last one bends too
+            cached.splineOffsets.resize(segments + 1, cached.splineOffsets.back());
+            cached.dirtyFirst = std::min(cached.dirtyFirst, known - 1);
+            cached.dirtyLast = segments - 1;
+        }
+        int first = std::max(cached.dirtyFirst, 0);
+        int last = std::min(cached.dirtyLast, segments - 1);
+        cached.dirtyFirst = INT_MAX;
+        cached.dirtyLast = -1;
+        if (first > last) return;
+        std::vector<int>& offsets = cached.splineOffsets;
+        // hidden segments collapse to their chord like the hidden parts of cubics
+        splineSamples.clear();
+        int added = 0;
+        float c[8];
+        for (int segment = first; segment <= last; segment++)
+        {
+            splineSegmentToCubic(type, nodes, count, segment, c);
+            bool hidden = std::max(std::max(c[0], c[2]), std::max(c[4], c[6])) < view[0]
+                || std::min(std::min(c[0], c[2]), std::min(c[4], c[6])) > view[1]
+                || std::max(std::max(c[1], c[3]), std::max(c[5], c[7])) < view[2]
+                || std::min(std::min(c[1], c[3]), std::min(c[5], c[7])) > view[3];
+            int samples = hidden ? 1 : cubicSampleCount(c, camera.pixels_per_unit(), LOD_TOLERANCE_PIXELS * toleranceScale);
+            splineSamples.push_back(samples);
+            added += samples;
+        }
+        // the vertices of the later segments only move if the patched ones changed their count
+        int removed = offsets[last + 1] - offsets[first];
+        std::vector<float>& vertices = cached.vertices;
+        if (added > removed)
+            vertices.insert(vertices.begin() + 2 * offsets[last + 1], 2 * (added - removed), 0.0f);
+        else if (added < removed)
+            vertices.erase(vertices.begin() + 2 * (offsets[first] + added), vertices.begin() + 2 * offsets[last + 1]);
+        for (int segment = first; segment <= last; segment++)
+        {
+            splineSegmentToCubic(type, nodes, count, segment, c);
+            int samples = splineSamples[segment - first];
+            // neighbours share their end vertex, both write the same point there
+            genCubicBezierCurve(samples, c, c + 2, c + 4, c + 6, &vertices[2 * offsets[segment]]);
+            offsets[segment + 1] = offsets[segment] + samples;
+        }
+        for (int segment = last + 2; segment <= segments; segment++)
+            offsets[segment] += added - removed;
+    }
+
+    void CurveProgram::begin_frame()
+    {
+        frameArena.reset();
+    }
+    
     void CurveProgram::refresh_line()
     {
-        switch (type)
+        float left, right, bottom, top;
+        camera.bounds(left, right, bottom, top);
+        // edits reach the live curve only, anything else changes the picture of every curve
+        float view[4] = { left, right, bottom, top };
+        if (activeCurve != layerCurve || !std::equal(view, view + 4, layerView)
+            || cubicHulls != layerHulls || evenSpacing != layerEvenSpacing
+            || toleranceScale != layerToleranceScale || allMarkers != layerAllMarkers)
+        {
+            layerRevision++;
+            layerCurve = activeCurve;
+            std::copy(view, view + 4, layerView);
+            layerHulls = cubicHulls;
+            layerEvenSpacing = evenSpacing;
+            layerToleranceScale = toleranceScale;
+            layerAllMarkers = allMarkers;
+        }
+        if (staticRevision != layerRevision)
+        {
+            // everything but the live curve goes in front, it stays there until the next revision
+            line_coords.clear();
+            drawList.clear();
+            hullControls.clear();
+            hullCurves.clear();
+            for (int curve = 0; curve < scene.curve_count(); curve++)
+                if (curve != activeCurve) add_curve_strips(curve);
+            for (int curve = 0; curve < scene.curve_count(); curve++)
+                if (allMarkers && curve != activeCurve) add_markers(curve);
+            staticRevision = layerRevision;
+            staticCoords = line_coords.size();
+            staticHulls = hullCurves.size();
+            drawList.keep();
+        }
+        else
+        {
+            line_coords.resize(staticCoords);
+            drawList.rewind();
+            hullControls.resize(8 * staticHulls);
+            hullCurves.resize(staticHulls);
+        }
+        if (activeCurve < 0 || activeCurve >= scene.curve_count()) return;
+        // the active curve keeps its markers, its points are the ones being grabbed
+        add_curve_strips(activeCurve);
+        add_markers(activeCurve);
+    }
+
+    void CurveProgram::add_curve_strips(int curve)
+    {
+        float left, right, bottom, top;
+        camera.bounds(left, right, bottom, top);
+        const PointArray& points = scene.points();
+        size_t first = scene.curve_first(curve);
+        size_t count = scene.curve_point_count(curve);
+        if (count == 0) return;
+        int firstVertex = line_coords.size() / 2;
+        switch (scene.curve_type(curve))
         {
         case curves::CurveType::CubicBezier:
-            line_coords = curves::genCubicBezierCurve(100, points.at(0), points.at(1), points.at(2), points.at(3));
+            if (cubicHulls)
+            {
+                // the segments are drawn as they are, so only the ones whose hull reaches into the view are kept
+                for (size_t start = first; start + 3 < first + count; start += 3)
+                {
+                    const float* c = &points[2 * start];
+                    if (std::max(std::max(c[0], c[2]), std::max(c[4], c[6])) < left
+                        || std::min(std::min(c[0], c[2]), std::min(c[4], c[6])) > right
+                        || std::max(std::max(c[1], c[3]), std::max(c[5], c[7])) < bottom
+                        || std::min(std::min(c[1], c[3]), std::min(c[5], c[7])) > top) continue;
+                    hullControls.insert(hullControls.end(), c, c + 8);
+                    hullCurves.push_back(curve);
+                }
+                break;
+            }
+            if (evenSpacing)
+            {
+                CurveCache& cached = curve_cache(curve);
+                // splits change the segment count without moving a point
+                if (cached.arcLengthDirty || cached.arcLength.segment_count() != ((int)count - 1) / 3)
+                {
+                    cached.arcLength.build(&points[2 * first], count);
+                    cached.arcLengthDirty = false;
+                }
+            }
+            line_coords.push_back(points[2 * first]);
+            line_coords.push_back(points[2 * first + 1]);
+            for (size_t start = first; start + 3 < first + count; start += 3)
+            {
+                const float* c = &points[2 * start];
+                int segment = (start - first) / 3;
+                // only the parts inside the view are sampled, and those at the density the zoom asks for
+                ArenaVector<ParamInterval> intervals((ArenaAllocator<ParamInterval>(frameArena)));
+                curves::clipCubicToRect(c, left, right, bottom, top, intervals);
+                for (const ParamInterval& interval : intervals)
+                {
+                    float part[8];
+                    curves::subCubic(c, interval.t0, interval.t1, part);
+                    // hidden parts collapse to their chord, which stays inside their (off-screen) hull
+                    int samples = 1;
+                    if (interval.visible)
+                        samples = curves::cubicSampleCount(part, camera.pixels_per_unit(), LOD_TOLERANCE_PIXELS * toleranceScale);
+                    // the first vertex is where the previous part ended, so it's overwritten in place
+                    size_t end = line_coords.size();
+                    if (evenSpacing && interval.visible)
+                    {
+                        // Vertices evenly along the length. Uniform t already puts more of them where the
+                        // curve is slow (which is where it bends), so keep Wang's count as the lower bound.
+                        const ArcLengthTable& table = curveCaches[curve].arcLength;
+                        float s0 = table.distance_at(&points[2 * first], segment, interval.t0);
+                        float s1 = table.distance_at(&points[2 * first], segment, interval.t1);
+                        int spaced = (int)std::ceil((s1 - s0) * camera.pixels_per_unit() / (ARC_SPACING_PIXELS * std::sqrt(toleranceScale)));
+                        samples = std::min(std::max(samples, spaced), MAX_CURVE_SAMPLES);
+                        line_coords.resize(end + 2 * samples);
+                        table.sample_even(&points[2 * first], s0, s1, samples, &line_coords[end - 2]);
+                        continue;
+                    }
+                    line_coords.resize(end + 2 * samples);
+                    curves::genCubicBezierCurve(samples, part, part + 2, part + 4, part + 6, &line_coords[end - 2]);
+                }
+            }
             break;
         case curves::CurveType::Lagrange:
-            line_coords = curves::genLagrangeCurve(100, points);
+        {
+            CurveCache& cached = curve_cache(curve);
+            int known = cached.polynomial.node_count();
+            if (cached.polynomialDirty || known != (int)count)
+            {
+                const float* nodes = &points[2 * first];
+                if (cached.polynomialDirty || known > (int)count)
+                    cached.polynomial.assign(nodes, count);
+                else
+                    // appended nodes only add a column to the divided differences
+                    for (int node = known; node < (int)count; node++)
+                        cached.polynomial.append(nodes[2 * node], nodes[2 * node + 1]);
+                int samples = std::min(std::max(LAGRANGE_SAMPLES_PER_NODE * ((int)count - 1), MIN_LAGRANGE_SAMPLES), MAX_LAGRANGE_SAMPLES);
+                // fewer samples at a coarser tolerance, as Wang's formula would give
+                samples = std::max((int)(samples / std::sqrt(toleranceScale)), 1);
+                cached.vertices.resize(2 * (samples + 1));
+                cached.polynomial.sample(samples, cached.vertices.data());
+                cached.polynomialDirty = false;
+            }
+            line_coords.insert(line_coords.end(), cached.vertices.begin(), cached.vertices.end());
             break;
         }
-        // add the point markers
-        for (float cross_coordinate : curves::genCrosses(points))
-            line_coords.push_back(cross_coordinate);
+        case curves::CurveType::CatmullRom:
+        case curves::CurveType::Centripetal:
+        case curves::CurveType::Cardinal:
+        {
+            update_spline(curve);
+            const std::vector<float>& vertices = curveCaches[curve].vertices;
+            line_coords.insert(line_coords.end(), vertices.begin(), vertices.end());
+            break;
+        }
+        case curves::CurveType::Nurbs:
+        {
+            CurveCache& cached = curve_cache(curve);
+            if (cached.nurbsDirty)
+            {
+                cached.nurbs.assign(scene.curve_nurbs(curve), &points[2 * first], count);
+                cached.nurbsDirty = false;
+            }
+            const NurbsEvaluator& nurbs = cached.nurbs;
+            line_coords.push_back(0.0f);
+            line_coords.push_back(0.0f);
+            for (int span = 0; span < nurbs.span_count(); span++)
+            {
+                // with positive weights a span stays inside the hull of its control points,
+                // spans outside of the view collapse to their chord
+                const float* c = &points[2 * (first + nurbs.span_first_point(span))];
+                int degree = scene.curve_nurbs(curve).degree;
+                float minX = c[0], maxX = c[0], minY = c[1], maxY = c[1];
+                for (int k = 1; k <= degree; k++)
+                {
+                    minX = std::min(minX, c[2 * k]);
+                    maxX = std::max(maxX, c[2 * k]);
+                    minY = std::min(minY, c[2 * k + 1]);
+                    maxY = std::max(maxY, c[2 * k + 1]);
+                }
+                int samples = 1;
+                if (maxX >= left && minX <= right && maxY >= bottom && minY <= top)
+                    samples = nurbs.span_sample_count(span, camera.pixels_per_unit(), LOD_TOLERANCE_PIXELS * toleranceScale);
+                // the first vertex is where the previous span ended, so it's overwritten in place
+                size_t end = line_coords.size();
+                line_coords.resize(end + 2 * samples);
+                nurbs.sample_span(span, samples, &line_coords[end - 2]);
+            }
+            break;
+        }
+        }
+        drawList.add_strip(DrawStyle::Curve, curve, firstVertex, line_coords.size() / 2 - firstVertex);
+    }
+
+    void CurveProgram::add_markers(int curve)
+    {
+        // only the points in view get a cross
+        float left, right, bottom, top;
+        camera.bounds(left, right, bottom, top);
+        const PointArray& points = scene.points();
+        ArenaVector<float> visiblePoints((ArenaAllocator<float>(frameArena)));
+        visiblePoints.reserve(2 * scene.curve_point_count(curve));
+        size_t end = scene.curve_first(curve) + scene.curve_point_count(curve);
+        for (size_t i = 2 * scene.curve_first(curve); i < 2 * end; i += 2)
+        {
+            if (points[i] < left || points[i] > right || points[i + 1] < bottom || points[i + 1] > top) continue;
+            visiblePoints.push_back(points[i]);
+            visiblePoints.push_back(points[i + 1]);
+        }
+        int firstVertex = line_coords.size() / 2;
+        int visibleCount = visiblePoints.size() / 2;
+        line_coords.resize(line_coords.size() + 8 * visibleCount);
+        curves::genCrosses(visiblePoints.data(), visibleCount, CROSS_SIZE_PIXELS * camera.pixel_size(), &line_coords[2 * firstVertex]);
+        // every stroke of a cross is a strip of its own
+        for (int v = firstVertex; v < (int)line_coords.size() / 2; v += 2)
+            drawList.add_strip(DrawStyle::Marker, curve, v, 2);
     }
 }
\ No newline at end of file
@@ -1,30 +1,164 @@
 #pragma once
 
 #include <glad/glad.h>
-#include <GLFW/glfw3.h>
 
+#include "arc_length.hpp"
+#include "camera.hpp"
 #include "curves.hpp"
+#include "curve_query.hpp"
+#include "draw_list.hpp"
+#include "edit_history.hpp"
+#include "frame_arena.hpp"
+#include "frame_governor.hpp"
+#include "lagrange.hpp"
+#include "nurbs.hpp"
+#include "point_grid.hpp"
+#include "scene.hpp"
 
 #include <string>
 
+// only passed through, the program itself doesn't need a window
+struct GLFWwindow;
+
 namespace curves
 {
     class CurveProgram
     {
     public:
         CurveProgram();
+        // replaces the drawing with a binary scene file or an SVG
+        bool load_scene(const std::string& path);
+        // writes the drawing as a binary scene file
+        bool save_scene(const std::string& path) const;
         void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+        // releases last frame's scratch memory
+        void begin_frame();
         void refresh_line();
         void press_mouse();
         void release_mouse();
-        void update_drag(GLFWwindow* window);
+        // the view is dragged with a second button and zoomed with the wheel
+        void press_pan();
+        void release_pan();
+        void scroll(double yoffset);
+        void cursor_moved(double xpos, double ypos, double time);
+        void resize_window(int width, int height);
+        // time is on the clock of cursor_moved
+        void update_drag(double time);
+        // one step is everything between pressing and releasing the left button
+        void undo();
+        void redo();
+        // adds an empty Lagrange or spline curve, clicks next to it append its points
+        void new_curve(CurveType type);
         const std::vector<float>& get_line_coords() const;
+        // strips into get_line_coords, the curves come first and the markers follow them
+        const DrawList& get_draw_list() const;
+        // with cubic hulls on, cubic segments aren't sampled into strips, their control points
+        // (8 floats per segment in view) go to get_hull_controls instead
+        void set_cubic_hulls(bool enable);
+        // samples cubics evenly along their length instead of evenly in t
+        void set_even_spacing(bool enable);
+        // coarser tessellation and fewer markers, for FrameGovernor
+        void set_quality(const QualityLevel& quality);
+        const std::vector<float>& get_hull_controls() const;
+        // the curve of every hull in get_hull_controls
+        const std::vector<int>& get_hull_curves() const;
+        // the curve being edited, it is redrawn every frame while the rest can be cached
+        int live_curve() const;
+        // changes whenever refresh_line gives anything but the live curve a different picture,
+        // until then the other curves' strips and hulls stay as they are, in front of the live curve's
+        unsigned layer_revision() const;
+        const Camera& get_camera() const;
     private:
+        void cursor_to_world(float& x, float& y) const;
+        // splits a cubic segment at t, returns the index of the new on-curve point
+        int insert_point(int segment, float t);
+        void rebuild_index();
+        // updates the picking structures after a point moved away from (oldX, oldY)
+        void point_moved(int point, float oldX, float oldY);
+        void apply_history(bool redo);
+        // resamples the segments of a spline curve whose points moved, or all of them when needed
+        void update_spline(int curve);
+        // strips (or hulls) and point markers of one curve, appended to the ones of refresh_line
+        void add_curve_strips(int curve);
+        void add_markers(int curve);
         // Variables to change the points later
-        curves::CurveType type;
-        int clicks;
+        curves::Scene scene;
+        // curve that was edited last, Lagrange and spline points are appended to it
+        int activeCurve;
+        // index of the point being dragged, -1 if none
+        int selected;
         std::vector<float> line_coords;
-        std::vector<std::vector<float>> points;
+        curves::DrawList drawList;
+        // derived data of every curve, kept until its points move
+        struct CurveCache
+        {
+            // vertices of the Lagrange and spline curves
+            std::vector<float> vertices;
+            // Lagrange curves
+            curves::NewtonPolynomial polynomial;
+            bool polynomialDirty;
+            // cubic curves, for even spacing
+            curves::ArcLengthTable arcLength;
+            bool arcLengthDirty;
+            // spline curves: segment k owns vertices [splineOffsets[k] : splineOffsets[k + 1]] (the ends are
+            // shared), so moving a point only rewrites the vertices of the segments next to it
+            std::vector<int> splineOffsets;
+            // view the vertices were made for, segments outside of it are only their chord
+            float splineView[4];
+            bool splineDirty;
+            // segments whose points moved since, INT_MAX and -1 if none
+            int dirtyFirst, dirtyLast;
+            // NURBS curves, weighted control points and spans
+            curves::NurbsEvaluator nurbs;
+            bool nurbsDirty;
+        };
+        // marks the caches of one curve, or of all of them for -1, for rebuilding
+        void invalidate_cache(int curve);
+        CurveCache& curve_cache(int curve);
+        std::vector<CurveCache> curveCaches;
+        // sample counts of the spline segments update_spline is patching
+        std::vector<int> splineSamples;
+        bool evenSpacing;
+        // LOD_TOLERANCE_PIXELS is multiplied by this
+        float toleranceScale;
+        // markers on every curve or only on the active one
+        bool allMarkers;
+        curves::EditHistory history;
+        std::vector<PointChange> historyChanges;
+        // scratch memory of refresh_line, valid until the next begin_frame
+        curves::FrameArena frameArena;
+        bool cubicHulls;
+        std::vector<float> hullControls;
+        std::vector<int> hullCurves;
+        unsigned layerRevision;
+        // live curve, view and settings of the last refresh_line, a change in them is a new revision
+        int layerCurve;
+        float layerView[4];
+        bool layerHulls, layerEvenSpacing;
+        float layerToleranceScale;
+        bool layerAllMarkers;
+        // revision the static curves in front of line_coords, drawList and the hulls were made for,
+        // and how much of each they take
+        unsigned staticRevision;
+        size_t staticCoords, staticHulls;
+        curves::PointGrid grid;
+        curves::SegmentBVH bvh;
+        // first point of every cubic segment in the scene, and the first segment of each curve
+        std::vector<int> segmentStarts;
+        std::vector<int> firstSegment;
+        bool indexDirty;
         bool mouseHeld;
+        // latest cursor event, coalesced until the next update_drag
+        double cursorX, cursorY;
+        // when the oldest of the coalesced events came in
+        double cursorTime;
+        bool cursorDirty;
+        int coalescedEvents;
+        // longest wait of an event for the frame that applied it, during the current drag
+        double worstLatency;
+        bool panning;
+        // cursor position the last pan step was applied at
+        double panX, panY;
+        curves::Camera camera;
     };
 }
\ No newline at end of file
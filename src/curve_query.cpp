@@ -0,0 +1,320 @@
+#include "curve_query.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace curves
+{
+    // segments per leaf
+    const int BVH_LEAF_SIZE = 4;
+    // subdivision stops once the control polygon is this close to its chord
+    const float FLATNESS = 1e-4f;
+    const int MAX_SUBDIVISIONS = 10;
+    const int NEWTON_ITERATIONS = 4;
+
+    namespace
+    {
+        float boxDistanceSquared(float minX, float minY, float maxX, float maxY, float x, float y)
+        {
+            float dx = std::max(std::max(minX - x, x - maxX), 0.0f);
+            float dy = std::max(std::max(minY - y, y - maxY), 0.0f);
+            return dx * dx + dy * dy;
+        }
+
+        void controlBounds(const float* c, float* box)
+        {
+            box[0] = std::min(std::min(c[0], c[2]), std::min(c[4], c[6]));
+            box[1] = std::min(std::min(c[1], c[3]), std::min(c[5], c[7]));
+            box[2] = std::max(std::max(c[0], c[2]), std::max(c[4], c[6]));
+            box[3] = std::max(std::max(c[1], c[3]), std::max(c[5], c[7]));
+        }
+
+        // distance of the inner control points to the chord, squared
+        float flatnessSquared(const float* c)
+        {
+            float cx = c[6] - c[0];
+            float cy = c[7] - c[1];
+            float length = cx * cx + cy * cy;
+            float worst = 0.0f;
+            for (int i = 2; i <= 4; i += 2)
+            {
+                float px = c[i] - c[0];
+                float py = c[i + 1] - c[1];
+                float d;
+                if (length > 0.0f)
+                {
+                    float cross = px * cy - py * cx;
+                    d = cross * cross / length;
+                }
+                else
+                {
+                    d = px * px + py * py;
+                }
+                worst = std::max(worst, d);
+            }
+            return worst;
+        }
+
+        float cubicDistanceSquared(const float* c, float t, float x, float y)
+        {
+            float u = 1 - t;
+            float bx = u * u * u * c[0] + 3 * u * u * t * c[2] + 3 * u * t * t * c[4] + t * t * t * c[6];
+            float by = u * u * u * c[1] + 3 * u * u * t * c[3] + 3 * u * t * t * c[5] + t * t * t * c[7];
+            return (bx - x) * (bx - x) + (by - y) * (by - y);
+        }
+
+        // minimizes |B(t) - P|^2 by Newton steps on (B(t) - P) . B'(t) = 0
+        float newtonRefine(const float* c, float t, float x, float y)
+        {
+            for (int i = 0; i < NEWTON_ITERATIONS; i++)
+            {
+                float u = 1 - t;
+                float bx = u * u * u * c[0] + 3 * u * u * t * c[2] + 3 * u * t * t * c[4] + t * t * t * c[6];
+                float by = u * u * u * c[1] + 3 * u * u * t * c[3] + 3 * u * t * t * c[5] + t * t * t * c[7];
+                float dx = 3 * (u * u * (c[2] - c[0]) + 2 * u * t * (c[4] - c[2]) + t * t * (c[6] - c[4]));
+                float dy = 3 * (u * u * (c[3] - c[1]) + 2 * u * t * (c[5] - c[3]) + t * t * (c[7] - c[5]));
+                float ddx = 6 * (u * (c[4] - 2 * c[2] + c[0]) + t * (c[6] - 2 * c[4] + c[2]));
+                float ddy = 6 * (u * (c[5] - 2 * c[3] + c[1]) + t * (c[7] - 2 * c[5] + c[3]));
+                float f = (bx - x) * dx + (by - y) * dy;
+                float df = dx * dx + dy * dy + (bx - x) * ddx + (by - y) * ddy;
+                if (df <= 1e-12f) break;
+                t = std::min(std::max(t - f / df, 0.0f), 1.0f);
+            }
+            return t;
+        }
+    }
+
+    CurveHit nearestOnCubic(const float* controls, float x, float y, float bestDistance)
+    {
+        CurveHit hit = { -1, 0.0f, bestDistance };
+        float best = bestDistance * bestDistance;
+        struct Piece
+        {
+            float c[8];
+            float t0, t1;
+            int depth;
+        };
+        Piece stack[2 * MAX_SUBDIVISIONS + 2];
+        int top = 0;
+        std::copy(controls, controls + 8, stack[0].c);
+        stack[0].t0 = 0.0f;
+        stack[0].t1 = 1.0f;
+        stack[0].depth = 0;
+        top = 1;
+        while (top > 0)
+        {
+            Piece piece = stack[--top];
+            float box[4];
+            controlBounds(piece.c, box);
+            // the curve lies inside the hull of its control points
+            if (boxDistanceSquared(box[0], box[1], box[2], box[3], x, y) > best) continue;
+            if (piece.depth >= MAX_SUBDIVISIONS || flatnessSquared(piece.c) < FLATNESS * FLATNESS)
+            {
+                // project onto the chord for a start value, then let Newton polish it on the full curve
+                float cx = piece.c[6] - piece.c[0];
+                float cy = piece.c[7] - piece.c[1];
+                float length = cx * cx + cy * cy;
+                float u = length > 0.0f ? ((x - piece.c[0]) * cx + (y - piece.c[1]) * cy) / length : 0.0f;
+                u = std::min(std::max(u, 0.0f), 1.0f);
+                float t = piece.t0 + (piece.t1 - piece.t0) * u;
+                float refined = newtonRefine(controls, t, x, y);
+                float d = cubicDistanceSquared(controls, t, x, y);
+                float dRefined = cubicDistanceSquared(controls, refined, x, y);
+                if (dRefined < d)
+                {
+                    d = dRefined;
+                    t = refined;
+                }
+                if (d <= best)
+                {
+                    best = d;
+                    hit.segment = 0;
+                    hit.t = t;
+                }
+                continue;
+            }
+            Piece left, right;
+            splitCubic(piece.c, 0.5f, left.c, right.c);
+            float mid = 0.5f * (piece.t0 + piece.t1);
+            left.t0 = piece.t0;
+            left.t1 = mid;
+            right.t0 = mid;
+            right.t1 = piece.t1;
+            left.depth = right.depth = piece.depth + 1;
+            // visit the half closer to the point first
+            float leftDistance = cubicDistanceSquared(left.c, 0.5f, x, y);
+            float rightDistance = cubicDistanceSquared(right.c, 0.5f, x, y);
+            if (leftDistance < rightDistance)
+            {
+                stack[top++] = right;
+                stack[top++] = left;
+            }
+            else
+            {
+                stack[top++] = left;
+                stack[top++] = right;
+            }
+        }
+        hit.distance = std::sqrt(best);
+        return hit;
+    }
+
+    void SegmentBVH::build(const float* points, const std::vector<int>& segmentStarts)
+    {
+        starts = segmentStarts;
+        nodes.clear();
+        int count = starts.size();
+        order.resize(count);
+        leafOf.assign(count, -1);
+        std::vector<float> centers(2 * count);
+        for (int i = 0; i < count; i++)
+        {
+            order[i] = i;
+            float box[4];
+            segment_bounds(points, i, box);
+            centers[2 * i] = 0.5f * (box[0] + box[2]);
+            centers[2 * i + 1] = 0.5f * (box[1] + box[3]);
+        }
+        if (count == 0) return;
+        nodes.reserve(2 * count / BVH_LEAF_SIZE + 1);
+        build_node(points, centers, 0, count, -1);
+        // the search holds at most the far children of the nodes above it and the two of the
+        // deepest inner node, children come after their parent
+        std::vector<int> depth(nodes.size(), 0);
+        int deepest = 0;
+        for (size_t i = 1; i < nodes.size(); i++)
+        {
+            depth[i] = depth[nodes[i].parent] + 1;
+            deepest = std::max(deepest, depth[i]);
+        }
+        stack.resize(deepest + 2);
+    }
+
+    int SegmentBVH::build_node(const float* points, std::vector<float>& centers, int first, int count, int parent)
+    {
+        int index = nodes.size();
+        Node node;
+        node.minX = node.minY = FLT_MAX;
+        node.maxX = node.maxY = -FLT_MAX;
+        node.left = node.right = -1;
+        node.first = first;
+        node.count = count;
+        node.parent = parent;
+        nodes.push_back(node);
+        if (count <= BVH_LEAF_SIZE)
+        {
+            for (int i = first; i < first + count; i++)
+            {
+                float box[4];
+                segment_bounds(points, order[i], box);
+                nodes[index].minX = std::min(nodes[index].minX, box[0]);
+                nodes[index].minY = std::min(nodes[index].minY, box[1]);
+                nodes[index].maxX = std::max(nodes[index].maxX, box[2]);
+                nodes[index].maxY = std::max(nodes[index].maxY, box[3]);
+                leafOf[order[i]] = index;
+            }
+            return index;
+        }
+        // split at the median of the centers along the longer axis
+        float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+        for (int i = first; i < first + count; i++)
+        {
+            minX = std::min(minX, centers[2 * order[i]]);
+            maxX = std::max(maxX, centers[2 * order[i]]);
+            minY = std::min(minY, centers[2 * order[i] + 1]);
+            maxY = std::max(maxY, centers[2 * order[i] + 1]);
+        }
+        int axis = (maxX - minX) >= (maxY - minY) ? 0 : 1;
+        int half = count / 2;
+        std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+            [&centers, axis](int a, int b) { return centers[2 * a + axis] < centers[2 * b + axis]; });
+        int left = build_node(points, centers, first, half, index);
+        int right = build_node(points, centers, first + half, count - half, index);
+        Node& self = nodes[index];
+        self.left = left;
+        self.right = right;
+        self.minX = std::min(nodes[left].minX, nodes[right].minX);
+        self.minY = std::min(nodes[left].minY, nodes[right].minY);
+        self.maxX = std::max(nodes[left].maxX, nodes[right].maxX);
+        self.maxY = std::max(nodes[left].maxY, nodes[right].maxY);
+        return index;
+    }
+
+    void SegmentBVH::refit_segment(const float* points, int segment)
+    {
+        if (segment < 0 || segment >= (int)leafOf.size()) return;
+        int index = leafOf[segment];
+        Node& leaf = nodes[index];
+        leaf.minX = leaf.minY = FLT_MAX;
+        leaf.maxX = leaf.maxY = -FLT_MAX;
+        for (int i = leaf.first; i < leaf.first + leaf.count; i++)
+        {
+            float box[4];
+            segment_bounds(points, order[i], box);
+            leaf.minX = std::min(leaf.minX, box[0]);
+            leaf.minY = std::min(leaf.minY, box[1]);
+            leaf.maxX = std::max(leaf.maxX, box[2]);
+            leaf.maxY = std::max(leaf.maxY, box[3]);
+        }
+        // walk up and re-merge the children
+        for (index = leaf.parent; index >= 0; index = nodes[index].parent)
+        {
+            Node& node = nodes[index];
+            const Node& left = nodes[node.left];
+            const Node& right = nodes[node.right];
+            node.minX = std::min(left.minX, right.minX);
+            node.minY = std::min(left.minY, right.minY);
+            node.maxX = std::max(left.maxX, right.maxX);
+            node.maxY = std::max(left.maxY, right.maxY);
+        }
+    }
+
+    CurveHit SegmentBVH::nearest(const float* points, float x, float y, float maxDistance) const
+    {
+        CurveHit best = { -1, 0.0f, maxDistance };
+        if (nodes.empty()) return best;
+        float bestSquared = maxDistance * maxDistance;
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            const Node& node = nodes[stack[--top]];
+            if (boxDistanceSquared(node.minX, node.minY, node.maxX, node.maxY, x, y) > bestSquared) continue;
+            if (node.left < 0)
+            {
+                for (int i = node.first; i < node.first + node.count; i++)
+                {
+                    int segment = order[i];
+                    CurveHit hit = nearestOnCubic(&points[2 * starts[segment]], x, y, best.distance);
+                    if (hit.segment < 0) continue;
+                    hit.segment = segment;
+                    best = hit;
+                    bestSquared = hit.distance * hit.distance;
+                }
+                continue;
+            }
+            // push the farther child first so the closer one is searched first
+            const Node& left = nodes[node.left];
+            const Node& right = nodes[node.right];
+            float leftDistance = boxDistanceSquared(left.minX, left.minY, left.maxX, left.maxY, x, y);
+            float rightDistance = boxDistanceSquared(right.minX, right.minY, right.maxX, right.maxY, x, y);
+            if (leftDistance < rightDistance)
+            {
+                stack[top++] = node.right;
+                stack[top++] = node.left;
+            }
+            else
+            {
+                stack[top++] = node.left;
+                stack[top++] = node.right;
+            }
+        }
+        return best;
+    }
+
+    void SegmentBVH::segment_bounds(const float* points, int segment, float* box) const
+    {
+        controlBounds(&points[2 * starts[segment]], box);
+    }
+}
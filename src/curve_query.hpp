@@ -0,0 +1,48 @@
+#pragma once
+
+#include "curves.hpp"
+
+#include <vector>
+
+namespace curves
+{
+    struct CurveHit
+    {
+        // index into the segment list the hierarchy was built from, -1 if nothing was in range
+        int segment;
+        float t;
+        float distance;
+    };
+
+    // Bounding box hierarchy over cubic Bezier segments for nearest-point queries.
+    // Segment i uses the four points starting at segmentStarts[i] in the flat x, y point array.
+    class SegmentBVH
+    {
+    public:
+        void build(const float* points, const std::vector<int>& segmentStarts);
+        // recomputes the boxes above one segment after its control points moved
+        void refit_segment(const float* points, int segment);
+        CurveHit nearest(const float* points, float x, float y, float maxDistance) const;
+    private:
+        struct Node
+        {
+            float minX, minY, maxX, maxY;
+            // leaves hold segments [first, first + count) of order, inner nodes have two children
+            int left, right;
+            int first, count;
+            int parent;
+        };
+        void segment_bounds(const float* points, int segment, float* box) const;
+        int build_node(const float* points, std::vector<float>& centers, int first, int count, int parent);
+        std::vector<Node> nodes;
+        std::vector<int> order;
+        std::vector<int> starts;
+        // leaf node of each segment, for refitting
+        std::vector<int> leafOf;
+        // nodes nearest still has to visit, sized by build to the depth of the tree so a query doesn't allocate
+        mutable std::vector<int> stack;
+    };
+
+    // closest point on one cubic (8 floats) to (x, y), only searched where it can beat bestDistance
+    CurveHit nearestOnCubic(const float* controls, float x, float y, float bestDistance);
+}
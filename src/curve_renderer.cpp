@@ -0,0 +1,628 @@
+#include "curve_renderer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace curves
+{
+    // allowed deviation of a 16-bit vertex from its float position
+    const float QUANTIZE_TOLERANCE_PIXELS = 0.25f;
+    const float STROKE_WIDTH_PIXELS = 3.0f;
+    // bits of the per-segment flags, the same values are used in stroke.vert
+    const uint8_t SEGMENT_VISIBLE = 1;
+    const uint8_t SEGMENT_HAS_PREV = 2;
+    const uint8_t SEGMENT_HAS_NEXT = 4;
+
+    static bool sameTransform(const Dequantize& a, const Dequantize& b)
+    {
+        return a.offsetX == b.offsetX && a.offsetY == b.offsetY && a.scaleX == b.scaleX && a.scaleY == b.scaleY;
+    }
+
+    CurveRenderer::CurveRenderer()
+    {
+        shader = strokeShader = hullShader = 0;
+        projectionLoc = dequantizeLoc = -1;
+        strokeProjectionLoc = strokeDequantizeLoc = strokeViewportLoc = strokeHalfWidthLoc = -1;
+        hullProjectionLoc = hullViewportLoc = hullHalfWidthLoc = -1;
+        floatVAO = compactVAO = 0;
+        strokeFloatVAO = strokeCompactVAO = 0;
+        hullVAO = hullVBO = 0;
+        hullBytes = 0;
+        hullCount = 0;
+        liveHullFirst = liveHullCount = 0;
+        liveCurve = -1;
+        layerCache = true;
+        revision = layerRevision = 0;
+        layerMode = LineMode::Hairline;
+        layerPass = Pass::All;
+        layerScale = 1.0f;
+        renderScale = 1.0f;
+        // nothing uploaded yet
+        uploadRevision = flagsRevision = hullRevision = revision - 1;
+        staticVertexCount = staticIndexCount = 0;
+        VBO = EBO = flagsVBO = 0;
+        vboBytes = eboBytes = flagsBytes = 0;
+        copyBuffer = 0;
+        copyBytes = 0;
+        trackedCompact = false;
+        compact = false;
+        lastCompact = false;
+        lineMode = LineMode::Hairline;
+        transform = FLOAT_VERTICES;
+        segmentCount = 0;
+        uploadedBytes = 0;
+        frameStats.bytes = frameStats.ranges = frameStats.copiedBytes = 0;
+    }
+
+    bool CurveRenderer::init(GLuint lineShader, GLuint strokeShader, GLuint hullShader, GLuint compositeShader)
+    {
+        shader = lineShader;
+        this->strokeShader = strokeShader;
+        this->hullShader = hullShader;
+        projectionLoc = glGetUniformLocation(shader, "projection");
+        dequantizeLoc = glGetUniformLocation(shader, "dequantize");
+        strokeProjectionLoc = glGetUniformLocation(strokeShader, "projection");
+        strokeDequantizeLoc = glGetUniformLocation(strokeShader, "dequantize");
+        strokeViewportLoc = glGetUniformLocation(strokeShader, "viewport");
+        strokeHalfWidthLoc = glGetUniformLocation(strokeShader, "halfWidth");
+        hullProjectionLoc = glGetUniformLocation(hullShader, "projection");
+        hullViewportLoc = glGetUniformLocation(hullShader, "viewport");
+        hullHalfWidthLoc = glGetUniformLocation(hullShader, "halfWidth");
+        if (projectionLoc < 0 || dequantizeLoc < 0 || strokeProjectionLoc < 0 || strokeDequantizeLoc < 0
+            || strokeViewportLoc < 0 || strokeHalfWidthLoc < 0
+            || hullProjectionLoc < 0 || hullViewportLoc < 0 || hullHalfWidthLoc < 0)
+        {
+            std::cerr << "ERROR::RENDERER::MISSING_UNIFORM" << std::endl;
+            return false;
+        }
+        if (!layer.init(compositeShader)) return false;
+        scaledTarget.init();
+
+        // --- Setup Buffers (VAO, VBO) (This part is purely generated with ChatGPT) ---
+        glGenVertexArrays(1, &floatVAO); // Create Vertex Array Object
+        glGenVertexArrays(1, &compactVAO);
+        glGenVertexArrays(1, &strokeFloatVAO);
+        glGenVertexArrays(1, &strokeCompactVAO);
+        glGenVertexArrays(1, &hullVAO);
+        glGenBuffers(1, &VBO);           // Create Vertex Buffer Object
+        glGenBuffers(1, &EBO);           // and the index buffer
+        glGenBuffers(1, &flagsVBO);
+        glGenBuffers(1, &hullVBO);
+        glGenBuffers(1, &copyBuffer);
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBO); // Bind VBO to the GL_ARRAY_BUFFER target
+
+        // Configure vertex attributes (tell OpenGL how to interpret the VBO data)
+        // layout (location = 0) in vec2 aPos; -> location 0
+        // vec2 -> size 2
+        // float -> type GL_FLOAT
+        // Normalize? -> GL_FALSE
+        // Stride (bytes between vertices) -> 2 * sizeof(float)
+        // Offset (bytes from start) -> 0
+        glBindVertexArray(floatVAO);
+        // the element buffer binding is part of the VAO state
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0); // Enable the vertex attribute (location 0)
+
+        // the compact layout reads shorts as they are, converted to float exactly
+        glBindVertexArray(compactVAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glVertexAttribPointer(0, 2, GL_SHORT, GL_FALSE, 2 * sizeof(int16_t), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        setup_stroke_vao(strokeFloatVAO, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0);
+        setup_stroke_vao(strokeCompactVAO, GL_SHORT, GL_FALSE, 2 * sizeof(int16_t), 0);
+        setup_hull_vao(0);
+
+        // Unbind VBO and VAO (good practice, prevents accidental modification)
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+
+        // the strips of a draw list are separated by this index
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(DrawList::RESTART_INDEX);
+        return true;
+    }
+
+    void CurveRenderer::setup_stroke_vao(GLuint vao, GLenum type, GLboolean normalized, GLsizei vertexSize, int firstInstance)
+    {
+        // instance i reads the vertices i - 1 (previous), i, i + 1 (the segment) and i + 2 (next),
+        // which are at slots i to i + 3 because of the padding vertex in front
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        for (int slot = 0; slot < 4; slot++)
+        {
+            glVertexAttribPointer(slot, 2, type, normalized, vertexSize, (void*)(size_t)((firstInstance + slot) * vertexSize));
+            glVertexAttribDivisor(slot, 1);
+            glEnableVertexAttribArray(slot);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, flagsVBO);
+        glVertexAttribIPointer(4, 1, GL_UNSIGNED_BYTE, 1, (void*)(size_t)firstInstance);
+        glVertexAttribDivisor(4, 1);
+        glEnableVertexAttribArray(4);
+    }
+
+    void CurveRenderer::setup_hull_vao(int firstInstance)
+    {
+        // one instance per cubic, its four control points are attributes 0 to 3
+        glBindVertexArray(hullVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, hullVBO);
+        for (int point = 0; point < 4; point++)
+        {
+            glVertexAttribPointer(point, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)((firstInstance * 4 + point) * 2 * sizeof(float)));
+            glVertexAttribDivisor(point, 1);
+            glEnableVertexAttribArray(point);
+        }
+    }
+
+    void CurveRenderer::destroy()
+    {
+        glDeleteVertexArrays(1, &floatVAO);
+        glDeleteVertexArrays(1, &compactVAO);
+        glDeleteVertexArrays(1, &strokeFloatVAO);
+        glDeleteVertexArrays(1, &strokeCompactVAO);
+        glDeleteVertexArrays(1, &hullVAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        glDeleteBuffers(1, &flagsVBO);
+        glDeleteBuffers(1, &hullVBO);
+        glDeleteBuffers(1, &copyBuffer);
+        layer.destroy();
+        scaledTarget.destroy();
+        floatVAO = compactVAO = strokeFloatVAO = strokeCompactVAO = hullVAO = 0;
+        VBO = EBO = flagsVBO = hullVBO = copyBuffer = 0;
+        vboBytes = eboBytes = flagsBytes = hullBytes = copyBytes = 0;
+        vertexTracker.reset();
+        indexTracker.reset();
+        flagsTracker.reset();
+        hullTracker.reset();
+    }
+
+    void CurveRenderer::upload(const std::vector<float>& coords, const DrawList& drawList, float pixelSize)
+    {
+        frameStats.bytes = frameStats.ranges = frameStats.copiedBytes = 0;
+        // while the revision stays, only the live curve at the end can have changed
+        bool kept = revision == uploadRevision;
+        uploadRevision = revision;
+        build_draws(drawList, coords.size() / 2, kept);
+        GLsizeiptr indexBytes = localIndices.size() * sizeof(uint32_t);
+        upload_tracked(GL_ELEMENT_ARRAY_BUFFER, EBO, eboBytes, indexBytes, 0, indexTracker, localIndices.data(), indexBytes,
+            indexSections, kept ? staticIndexCount * sizeof(uint32_t) : 0);
+        if (lineMode == LineMode::Stroke)
+        {
+            bool flagsKept = revision == flagsRevision;
+            flagsRevision = revision;
+            build_segment_flags(drawList.get_indices(), coords.size() / 2, flagsKept);
+            upload_tracked(GL_ARRAY_BUFFER, flagsVBO, flagsBytes, segmentFlags.size(), 0, flagsTracker,
+                segmentFlags.data(), segmentFlags.size(), scaled_sections(1), flagsKept ? staticVertexCount : 0);
+        }
+
+        Dequantize previous = transform;
+        lastCompact = compact && quantizeVertices(coords, QUANTIZE_TOLERANCE_PIXELS * pixelSize, quantized, transform);
+        if (!lastCompact)
+        {
+            // too large a drawing for 16 bits at this zoom, fall back to floats
+            transform = FLOAT_VERTICES;
+            upload_vertices(coords.data(), coords.size() / 2, 2 * sizeof(float), kept ? staticVertexCount : 0);
+            return;
+        }
+#ifdef DEBUG
+        // compare against the float path
+        float worst = 0.0f;
+        for (size_t i = 0; i + 1 < coords.size(); i += 2)
+        {
+            float x = transform.offsetX + transform.scaleX * quantized[i];
+            float y = transform.offsetY + transform.scaleY * quantized[i + 1];
+            worst = std::max(worst, std::hypot(x - coords[i], y - coords[i + 1]));
+        }
+        if (worst > QUANTIZE_TOLERANCE_PIXELS * pixelSize)
+            std::cerr << "ERROR::RENDERER::QUANTIZATION_ERROR " << worst / pixelSize << " pixels" << std::endl;
+#endif
+        // a box that grew or shrank moves every quantized vertex
+        upload_vertices(quantized.data(), quantized.size() / 2, 2 * sizeof(int16_t),
+            kept && sameTransform(previous, transform) ? staticVertexCount : 0);
+    }
+
+    void CurveRenderer::upload_hulls(const std::vector<float>& controls, const std::vector<int>& curves)
+    {
+        hullCount = controls.size() / 8;
+        bool kept = revision == hullRevision;
+        hullRevision = revision;
+        // the live curve's hulls are the run at the end
+        liveHullFirst = std::find(curves.begin(), curves.end(), liveCurve) - curves.begin();
+        liveHullCount = (int)curves.size() - liveHullFirst;
+        GLsizeiptr bytes = controls.size() * sizeof(float);
+        // hulls come and go with the view, so the static ones are one section and the live ones another
+        size_t staticBytes = liveHullFirst * 8 * sizeof(float);
+        byteSections.clear();
+        BufferSection stay = { 0, 0, staticBytes };
+        BufferSection live = { 1, staticBytes, (size_t)bytes - staticBytes };
+        byteSections.push_back(stay);
+        byteSections.push_back(live);
+        upload_tracked(GL_ARRAY_BUFFER, hullVBO, hullBytes, bytes, 0, hullTracker, controls.data(), bytes, byteSections,
+            kept ? staticBytes : 0);
+    }
+
+    void CurveRenderer::build_draws(const DrawList& drawList, int vertexCount, bool kept)
+    {
+        const std::vector<uint32_t>& indices = drawList.get_indices();
+        const std::vector<DrawRange>& ranges = drawList.get_ranges();
+        const uint32_t R = DrawList::RESTART_INDEX;
+        localIndices.resize(indices.size());
+        DrawSet* sets[2] = { &staticDraws, &liveDraws };
+        for (DrawSet* set : sets)
+        {
+            set->counts.clear();
+            set->offsets.clear();
+            set->baseVertices.clear();
+            set->batchFirst.clear();
+            set->batchStyles.clear();
+            set->spans.clear();
+            set->spanStyles.clear();
+        }
+        vertexSections.clear();
+        indexSections.clear();
+        staticVertexCount = vertexCount;
+        staticIndexCount = indices.size();
+        for (const DrawRange& range : ranges)
+        {
+            bool live = range.curve == liveCurve;
+            if (live)
+            {
+                staticVertexCount = std::min(staticVertexCount, range.firstVertex);
+                staticIndexCount = std::min(staticIndexCount, range.firstIndex);
+            }
+            add_draw(live ? liveDraws : staticDraws, range);
+            // the static indices are still there from the last time
+            if (kept && !live) continue;
+            for (int k = range.firstIndex; k < range.firstIndex + range.indexCount; k++)
+                localIndices[k] = indices[k] == R ? R : indices[k] - range.firstVertex;
+        }
+        for (const DrawRange& range : ranges)
+        {
+            // ranges come sorted by style and then by curve, the live curve's after all others
+            uint64_t key = ((uint64_t)(range.curve == liveCurve) << 33) | ((uint64_t)range.style << 32) | (uint32_t)range.curve;
+            BufferSection vertices = { key, (size_t)range.firstVertex, (size_t)range.vertexCount };
+            vertexSections.push_back(vertices);
+            BufferSection curveIndices = { key, range.firstIndex * sizeof(uint32_t), range.indexCount * sizeof(uint32_t) };
+            indexSections.push_back(curveIndices);
+        }
+        for (DrawSet* set : sets)
+            set->batchFirst.push_back(set->counts.size());
+    }
+
+    void CurveRenderer::add_draw(DrawSet& set, const DrawRange& range)
+    {
+        if (set.batchStyles.empty() || set.batchStyles.back() != range.style)
+        {
+            set.batchFirst.push_back(set.counts.size());
+            set.batchStyles.push_back(range.style);
+        }
+        set.counts.push_back(range.indexCount);
+        set.offsets.push_back((const void*)(range.firstIndex * sizeof(uint32_t)));
+        // the base vertex also skips the padding
+        set.baseVertices.push_back(range.firstVertex + 1);
+        // neighbouring ranges of a style stroke as one span, segments across strips aren't flagged
+        if (!set.spanStyles.empty() && set.spanStyles.back() == range.style
+            && set.spans[set.spans.size() - 2] + set.spans.back() == range.firstVertex)
+        {
+            set.spans.back() += range.vertexCount;
+            return;
+        }
+        set.spans.push_back(range.firstVertex);
+        set.spans.push_back(range.vertexCount);
+        set.spanStyles.push_back(range.style);
+    }
+
+    const std::vector<BufferSection>& CurveRenderer::scaled_sections(size_t size)
+    {
+        byteSections = vertexSections;
+        for (BufferSection& section : byteSections)
+        {
+            section.offset *= size;
+            section.bytes *= size;
+        }
+        return byteSections;
+    }
+
+    void CurveRenderer::build_segment_flags(const std::vector<uint32_t>& indices, size_t vertexCount, bool kept)
+    {
+        // a segment exists where a strip steps from vertex i to i + 1, the last vertex gets
+        // an empty entry so the flags line up with the vertex sections
+        segmentCount = vertexCount > 0 ? vertexCount - 1 : 0;
+        // the static strips keep their flags from the last time
+        size_t firstVertex = kept ? std::min((size_t)staticVertexCount, vertexCount) : 0;
+        size_t firstIndex = kept ? staticIndexCount : 0;
+        segmentFlags.resize(vertexCount);
+        std::fill(segmentFlags.begin() + firstVertex, segmentFlags.end(), 0);
+        const uint32_t R = DrawList::RESTART_INDEX;
+        for (size_t k = firstIndex; k + 1 < indices.size(); k++)
+        {
+            uint32_t i = indices[k];
+            if (i == R || indices[k + 1] != i + 1) continue;
+            uint8_t flags = SEGMENT_VISIBLE;
+            if (k > 0 && indices[k - 1] == i - 1) flags |= SEGMENT_HAS_PREV;
+            if (k + 2 < indices.size() && indices[k + 2] == i + 2) flags |= SEGMENT_HAS_NEXT;
+            segmentFlags[i] = flags;
+        }
+    }
+
+    void CurveRenderer::upload_vertices(const void* data, size_t vertexCount, GLsizei vertexSize, size_t kept)
+    {
+        // the other format's bytes mean nothing in this one
+        if (lastCompact != trackedCompact) vertexTracker.reset();
+        trackedCompact = lastCompact;
+        // one padding vertex in front and two behind keep every stroke instance inside the buffer
+        upload_tracked(GL_ARRAY_BUFFER, VBO, vboBytes, (vertexCount + 3) * vertexSize, vertexSize, vertexTracker,
+            data, vertexCount * vertexSize, scaled_sections(vertexSize), kept * vertexSize);
+    }
+
+    void CurveRenderer::upload_tracked(GLenum target, GLuint buffer, GLsizeiptr& capacity, GLsizeiptr reserveBytes, GLintptr base,
+        DirtyRangeTracker& tracker, const void* data, size_t bytes, const std::vector<BufferSection>& sections, size_t kept)
+    {
+        // a buffer that had to grow starts out empty
+        if (reserve(target, buffer, capacity, reserveBytes)) tracker.reset();
+        tracker.update(data, bytes, sections, kept);
+        copy_within(buffer, base, tracker.get_copies());
+        for (const ByteRange& range : tracker.get_uploads())
+            upload_bytes(target, buffer, base + range.offset, (const char*)data + range.offset, range.bytes);
+    }
+
+    void CurveRenderer::copy_within(GLuint buffer, GLintptr base, const std::vector<ByteCopy>& copies)
+    {
+        if (copies.empty()) return;
+        GLsizeiptr total = 0;
+        for (const ByteCopy& copy : copies)
+            total += copy.bytes;
+        // a copy may land on the source of a later one, so all of them are read out first
+        reserve(GL_COPY_WRITE_BUFFER, copyBuffer, copyBytes, total);
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, copyBuffer);
+        GLintptr packed = 0;
+        for (const ByteCopy& copy : copies)
+        {
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, base + copy.from, packed, copy.bytes);
+            packed += copy.bytes;
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, copyBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        packed = 0;
+        for (const ByteCopy& copy : copies)
+        {
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, packed, base + copy.to, copy.bytes);
+            packed += copy.bytes;
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        frameStats.copiedBytes += total;
+    }
+
+    bool CurveRenderer::reserve(GLenum target, GLuint buffer, GLsizeiptr& capacity, GLsizeiptr bytes)
+    {
+        if (bytes <= capacity) return false;
+        // Lagrange nodes can be added, so the buffers have to grow with the points
+        capacity = bytes * 2;
+        glBindVertexArray(floatVAO);
+        glBindBuffer(target, buffer);
+        glBufferData(target, capacity, NULL, GL_DYNAMIC_DRAW);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return true;
+    }
+
+    void CurveRenderer::upload_bytes(GLenum target, GLuint buffer, GLintptr offset, const void* data, GLsizeiptr bytes)
+    {
+        // the element buffer binding lives in the VAO, so bind it through one that already holds it
+        glBindVertexArray(floatVAO);
+        glBindBuffer(target, buffer);
+        glBufferSubData(target, offset, bytes, data);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        uploadedBytes += bytes;
+        frameStats.bytes += bytes;
+        frameStats.ranges++;
+    }
+
+    void CurveRenderer::draw(const float* projection)
+    {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        if (renderScale < 1.0f)
+        {
+            GLint scaled[4] = { 0, 0, std::max(1, (int)(viewport[2] * renderScale + 0.5f)),
+                std::max(1, (int)(viewport[3] * renderScale + 0.5f)) };
+            if (scaledTarget.begin(scaled[2], scaled[3]))
+            {
+                glViewport(0, 0, scaled[2], scaled[3]);
+                draw_scene(projection, scaled, Pass::Curves);
+                scaledTarget.end();
+                glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+                scaledTarget.present(viewport);
+                // markers are a few vertices each and should stay sharp, they aren't worth caching either
+                draw_set(projection, viewport, false, Pass::Markers);
+                draw_set(projection, viewport, true, Pass::Markers);
+                return;
+            }
+        }
+        draw_scene(projection, viewport, Pass::All);
+    }
+
+    void CurveRenderer::draw_scene(const float* projection, const GLint* viewport, Pass pass)
+    {
+        bool pasted = false;
+        if (layerCache)
+        {
+            if (!layer.is_valid(viewport[2], viewport[3]) || layerRevision != revision || layerMode != lineMode
+                || layerPass != pass || layerScale != renderScale)
+            {
+                // the camera, the window or a curve that isn't live changed
+                if (layer.begin_update(viewport[2], viewport[3]))
+                {
+                    draw_set(projection, viewport, false, pass);
+                    layer.end_update();
+                    layerRevision = revision;
+                    layerMode = lineMode;
+                    layerPass = pass;
+                    layerScale = renderScale;
+                }
+            }
+            if (layer.is_valid(viewport[2], viewport[3]))
+            {
+                layer.composite();
+                pasted = true;
+            }
+        }
+        if (!pasted) draw_set(projection, viewport, false, pass);
+        draw_set(projection, viewport, true, pass);
+    }
+
+    void CurveRenderer::draw_set(const float* projection, const GLint* viewport, bool live, Pass pass)
+    {
+        const DrawSet& set = live ? liveDraws : staticDraws;
+        // widths are in window pixels, a smaller target gets thinner strokes that come out the same once stretched
+        float halfWidth = 0.5f * STROKE_WIDTH_PIXELS * (pass == Pass::Curves ? renderScale : 1.0f);
+        if (lineMode == LineMode::Stroke)
+        {
+            glUseProgram(strokeShader);
+            glUniformMatrix4fv(strokeProjectionLoc, 1, GL_FALSE, projection);
+            glUniform4f(strokeDequantizeLoc, transform.offsetX, transform.offsetY, transform.scaleX, transform.scaleY);
+            glUniform2f(strokeViewportLoc, (float)viewport[2], (float)viewport[3]);
+            glUniform1f(strokeHalfWidthLoc, halfWidth);
+            // coverage goes out as alpha, the framebuffer keeps its own so the static layer and
+            // exported frames stay opaque
+            glEnable(GL_BLEND);
+            glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE);
+            for (size_t s = 0; s < set.spans.size(); s += 2)
+            {
+                bool marker = set.spanStyles[s / 2] == DrawStyle::Marker;
+                if ((pass == Pass::Curves && marker) || (pass == Pass::Markers && !marker)) continue;
+                int first = set.spans[s];
+                int end = std::min(first + set.spans[s + 1], (int)segmentCount);
+                int count = end - first;
+                if (count <= 0) continue;
+                if (lastCompact)
+                    setup_stroke_vao(strokeCompactVAO, GL_SHORT, GL_FALSE, 2 * sizeof(int16_t), first);
+                else
+                    setup_stroke_vao(strokeFloatVAO, GL_FLOAT, GL_FALSE, 2 * sizeof(float), first);
+                // a quad (4 vertex triangle strip) for every segment, the ones between strips collapse in the shader
+                glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+            }
+            glBindVertexArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glDisable(GL_BLEND);
+            return;
+        }
+
+        // Use the shader program
+        glUseProgram(shader);
+        glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, projection);
+        glUniform4f(dequantizeLoc, transform.offsetX, transform.offsetY, transform.scaleX, transform.scaleY);
+
+        // Bind the VAO matching the last upload
+        glBindVertexArray(lastCompact ? compactVAO : floatVAO);
+        // Draw the lines!
+        // GL_LINE_STRIP connects vertices in a line, the restart index ends a strip.
+        // All curves are one batch, the crosses another one, each curve with its own base vertex.
+        for (size_t batch = 0; batch + 1 < set.batchFirst.size(); batch++)
+        {
+            bool marker = set.batchStyles[batch] == DrawStyle::Marker;
+            if ((pass == Pass::Curves && marker) || (pass == Pass::Markers && !marker)) continue;
+            int first = set.batchFirst[batch];
+            glMultiDrawElementsBaseVertex(GL_LINE_STRIP, &set.counts[first], GL_UNSIGNED_INT, &set.offsets[first],
+                set.batchFirst[batch + 1] - first, &set.baseVertices[first]);
+        }
+        glBindVertexArray(0);
+        if (lineMode != LineMode::Hull || pass == Pass::Markers) return;
+        if (live)
+        {
+            draw_hulls(projection, viewport, liveHullFirst, liveHullCount, halfWidth);
+        }
+        else
+        {
+            // the live curve's hulls are the run at the end
+            draw_hulls(projection, viewport, 0, liveHullFirst, halfWidth);
+        }
+    }
+
+    void CurveRenderer::draw_hulls(const float* projection, const GLint* viewport, int first, int count, float halfWidth)
+    {
+        if (count <= 0) return;
+        glUseProgram(hullShader);
+        glUniformMatrix4fv(hullProjectionLoc, 1, GL_FALSE, projection);
+        glUniform2f(hullViewportLoc, (float)viewport[2], (float)viewport[3]);
+        glUniform1f(hullHalfWidthLoc, halfWidth);
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE);
+        setup_hull_vao(first);
+        // 4 vertices per segment, whatever the zoom
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glDisable(GL_BLEND);
+    }
+
+    void CurveRenderer::set_live_curve(int curve, unsigned revision)
+    {
+        liveCurve = curve;
+        this->revision = revision;
+    }
+
+    void CurveRenderer::set_layer_cache(bool enable)
+    {
+        // whatever happened while it was off isn't in the layer
+        if (enable && !layerCache) layer.invalidate();
+        layerCache = enable;
+    }
+
+    bool CurveRenderer::is_layer_cached() const
+    {
+        return layerCache;
+    }
+
+    void CurveRenderer::set_render_scale(float scale)
+    {
+        renderScale = std::min(std::max(scale, 0.1f), 1.0f);
+    }
+
+    float CurveRenderer::get_render_scale() const
+    {
+        return renderScale;
+    }
+
+    void CurveRenderer::set_compact(bool enable)
+    {
+        compact = enable;
+    }
+
+    bool CurveRenderer::is_compact() const
+    {
+        return compact;
+    }
+
+    bool CurveRenderer::uploaded_compact() const
+    {
+        return lastCompact;
+    }
+
+    void CurveRenderer::set_line_mode(LineMode mode)
+    {
+        lineMode = mode;
+    }
+
+    LineMode CurveRenderer::get_line_mode() const
+    {
+        return lineMode;
+    }
+
+    size_t CurveRenderer::get_uploaded_bytes() const
+    {
+        return uploadedBytes;
+    }
+
+    const UploadStats& CurveRenderer::get_frame_stats() const
+    {
+        return frameStats;
+    }
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "dirty_ranges.hpp"
+#include "draw_list.hpp"
+#include "scaled_target.hpp"
+#include "static_layer.hpp"
+#include "vertex_format.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace curves
+{
+    enum class LineMode
+    {
+        // 1 pixel GL_LINE_STRIP
+        Hairline,
+        // anti-aliased quads of STROKE_WIDTH_PIXELS, one instance per segment
+        Stroke,
+        // cubic segments are drawn from their control points, the fragment shader measures the
+        // distance to the curve itself. Everything else stays a hairline.
+        Hull
+    };
+
+    // what went to the GPU since the last upload
+    struct UploadStats
+    {
+        size_t bytes;
+        // glBufferSubData calls
+        size_t ranges;
+        // moved inside the buffers without going through the CPU
+        size_t copiedBytes;
+    };
+
+    // Owns the vertex buffers and issues the draw calls for a CurveProgram.
+    // Vertices go up either as float pairs or, in compact mode, as 16-bit integer pairs
+    // that the vertex shaders turn back into world coordinates with the "dequantize" uniform.
+    // Every buffer remembers what it holds, only the parts of a curve that changed are sent again
+    // and curves that just shifted are moved on the GPU. Each curve is drawn with its own base
+    // vertex, so its indices don't change when the curves in front of it grow or shrink.
+    // With the layer cache on, everything but the live curve is drawn into a StaticLayer once
+    // and only pasted in the following frames, until the revision passed with the live curve changes.
+    // Below a render scale of 1 the curves are drawn into a smaller ScaledTarget and stretched over
+    // the window, the markers are drawn on top of that at full resolution.
+    class CurveRenderer
+    {
+    public:
+        CurveRenderer();
+        // lineShader draws the draw list as strips, strokeShader expands its segments into quads,
+        // hullShader covers the control point box of every cubic
+        // compositeShader pastes the static layer
+        bool init(GLuint lineShader, GLuint strokeShader, GLuint hullShader, GLuint compositeShader);
+        void destroy();
+        // pixelSize is the world size of one pixel, the compact format is only used while its
+        // rounding error stays below QUANTIZE_TOLERANCE_PIXELS of it
+        void upload(const std::vector<float>& coords, const DrawList& drawList, float pixelSize);
+        // 8 floats per cubic segment and the curve of each (the live curve's last), for LineMode::Hull
+        void upload_hulls(const std::vector<float>& controls, const std::vector<int>& curves);
+        // the curve drawn every frame (-1 for none) and a number that changes whenever anything
+        // else in the picture does, call it before the uploads. As long as the number stays, the other
+        // curves have to come first in the uploads and stay as they are, only the live curve is compared.
+        void set_live_curve(int curve, unsigned revision);
+        void set_layer_cache(bool enable);
+        bool is_layer_cached() const;
+        // fraction of the window's width and height the curves are drawn at, 1 draws straight to it
+        void set_render_scale(float scale);
+        float get_render_scale() const;
+        // one multi-draw per style batch of the draw list that was uploaded last
+        void draw(const float* projection);
+        void set_compact(bool enable);
+        bool is_compact() const;
+        // whether the last upload really used 16-bit vertices
+        bool uploaded_compact() const;
+        void set_line_mode(LineMode mode);
+        LineMode get_line_mode() const;
+        // all bytes uploaded so far
+        size_t get_uploaded_bytes() const;
+        const UploadStats& get_frame_stats() const;
+    private:
+        // what a draw_set call covers
+        enum class Pass
+        {
+            All,
+            Curves,
+            Markers
+        };
+        // grows buffer to at least bytes, keeping nothing, returns whether it did
+        bool reserve(GLenum target, GLuint buffer, GLsizeiptr& capacity, GLsizeiptr bytes);
+        void upload_bytes(GLenum target, GLuint buffer, GLintptr offset, const void* data, GLsizeiptr bytes);
+        // sends what changed in data (placed at base in buffer) since the last call with this tracker
+        // (the first kept bytes are known to be unchanged)
+        void upload_tracked(GLenum target, GLuint buffer, GLsizeiptr& capacity, GLsizeiptr reserveBytes, GLintptr base,
+            DirtyRangeTracker& tracker, const void* data, size_t bytes, const std::vector<BufferSection>& sections, size_t kept);
+        void copy_within(GLuint buffer, GLintptr base, const std::vector<ByteCopy>& copies);
+        void upload_vertices(const void* data, size_t vertexCount, GLsizei vertexSize, size_t kept);
+        // draws of the static or of the live curves, one per curve and style, with indices
+        // relative to the curve's first vertex
+        struct DrawSet
+        {
+            std::vector<GLsizei> counts;
+            std::vector<const void*> offsets;
+            std::vector<GLint> baseVertices;
+            // draws [batchFirst[b] : batchFirst[b + 1]) have style batchStyles[b]
+            std::vector<int> batchFirst;
+            std::vector<DrawStyle> batchStyles;
+            // vertex ranges (first, count) the draws use and their styles, for the stroke instances
+            std::vector<int> spans;
+            std::vector<DrawStyle> spanStyles;
+        };
+        // splits the draw list into the two sets and makes the buffer sections of the curves,
+        // with kept the static indices are left as they were
+        void build_draws(const DrawList& drawList, int vertexCount, bool kept);
+        static void add_draw(DrawSet& set, const DrawRange& range);
+        // the static layer (or the static set) and then the live set, into the current framebuffer
+        void draw_scene(const float* projection, const GLint* viewport, Pass pass);
+        // the part of the static or live set that belongs to pass
+        void draw_set(const float* projection, const GLint* viewport, bool live, Pass pass);
+        // vertexSections with every vertex taking size bytes
+        const std::vector<BufferSection>& scaled_sections(size_t size);
+        // points the instanced attributes at segment firstInstance, GL 3.3 has no base instance
+        void setup_stroke_vao(GLuint vao, GLenum type, GLboolean normalized, GLsizei vertexSize, int firstInstance);
+        void setup_hull_vao(int firstInstance);
+        void build_segment_flags(const std::vector<uint32_t>& indices, size_t vertexCount, bool kept);
+        void draw_hulls(const float* projection, const GLint* viewport, int first, int count, float halfWidth);
+        GLuint shader, strokeShader, hullShader;
+        GLint projectionLoc, dequantizeLoc;
+        GLint strokeProjectionLoc, strokeDequantizeLoc, strokeViewportLoc, strokeHalfWidthLoc;
+        GLint hullProjectionLoc, hullViewportLoc, hullHalfWidthLoc;
+        // one vertex array per format and mode, all read from the same buffers
+        GLuint floatVAO, compactVAO;
+        GLuint strokeFloatVAO, strokeCompactVAO;
+        // hull instances are always floats, they are a fraction of the sampled vertices
+        GLuint hullVAO, hullVBO;
+        GLsizeiptr hullBytes;
+        size_t hullCount;
+        // the hulls of the live curve
+        int liveHullFirst, liveHullCount;
+        // the vertices start one vertex into VBO, so each stroke instance can read the vertex before its segment
+        GLuint VBO, EBO, flagsVBO;
+        GLsizeiptr vboBytes, eboBytes, flagsBytes;
+        // scratch space for moving bytes inside a buffer
+        GLuint copyBuffer;
+        GLsizeiptr copyBytes;
+        DirtyRangeTracker vertexTracker, indexTracker, flagsTracker, hullTracker;
+        // format the vertex tracker has seen last
+        bool trackedCompact;
+        std::vector<uint32_t> localIndices;
+        DrawSet staticDraws, liveDraws;
+        int liveCurve;
+        StaticLayer layer;
+        bool layerCache;
+        // revision of the static curves, and what the layer was drawn for
+        unsigned revision;
+        unsigned layerRevision;
+        LineMode layerMode;
+        Pass layerPass;
+        float layerScale;
+        ScaledTarget scaledTarget;
+        float renderScale;
+        // revision of the last vertex and index upload, of the last segment flags and of the last hulls
+        unsigned uploadRevision, flagsRevision, hullRevision;
+        // the static curves' vertices and indices in front of the live curve's
+        int staticVertexCount, staticIndexCount;
+        // per curve and style, in vertices and in index bytes
+        std::vector<BufferSection> vertexSections, indexSections;
+        std::vector<BufferSection> byteSections;
+        bool compact;
+        bool lastCompact;
+        LineMode lineMode;
+        Dequantize transform;
+        std::vector<int16_t> quantized;
+        // per segment (vertex i to i + 1) SEGMENT_* bits for the stroke path
+        std::vector<uint8_t> segmentFlags;
+        size_t segmentCount;
+        size_t uploadedBytes;
+        UploadStats frameStats;
+    };
+}
@@ -1,41 +1,278 @@
 #include "curves.hpp"
+#include "lagrange.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
 
 namespace curves
 {
-    std::vector<float> genCubicBezierCurve(int numPoints, const std::vector<float>& p0, const std::vector<float>& p1, const std::vector<float>& p2, const std::vector<float>& p3)
+    // basis arrays start on this boundary (in bytes) so the evaluation loop can use aligned vector loads
+    const size_t BASIS_ALIGNMENT = 32;
+
+    namespace
     {
-        std::vector<float> points = p0;
-        for (int i = 1; i <= numPoints; i++)
+        // Bernstein weights of the samples t = i / numPoints, one array per basis function
+        struct BernsteinBasis
+        {
+            std::vector<float> storage;
+            const float* weights[4];
+        };
+
+        const BernsteinBasis& bernsteinBasis(int numPoints)
         {
-            float t = (float)i / (float)numPoints;
-            points.push_back(pow(1 - t, 3) * p0[0] + 3 * pow(1 - t, 2) * t * p1[0] + 3 * (1 - t) * pow(t, 2) * p2[0] + pow(t, 3) * p3[0]);
-            points.push_back(pow(1 - t, 3) * p0[1] + 3 * pow(1 - t, 2) * t * p1[1] + 3 * (1 - t) * pow(t, 2) * p2[1] + pow(t, 3) * p3[1]);
+            // one cache per thread, so lookups need no lock
+            thread_local std::vector<std::unique_ptr<BernsteinBasis>> cache;
+            if ((int)cache.size() <= numPoints) cache.resize(numPoints + 1);
+            std::unique_ptr<BernsteinBasis>& entry = cache[numPoints];
+            if (entry) return *entry;
+            entry.reset(new BernsteinBasis());
+            const size_t perFloat = BASIS_ALIGNMENT / sizeof(float);
+            // every array padded to the alignment
+            size_t stride = (numPoints + 1 + perFloat - 1) / perFloat * perFloat;
+            entry->storage.assign(4 * stride + perFloat, 0.0f);
+            float* base = entry->storage.data();
+            while ((uintptr_t)base % BASIS_ALIGNMENT != 0) base++;
+            for (int k = 0; k < 4; k++)
+                entry->weights[k] = base + k * stride;
+            for (int i = 0; i <= numPoints; i++)
+            {
+                float t = numPoints > 0 ? (float)i / (float)numPoints : 0.0f;
+                float u = 1 - t;
+                base[i] = u * u * u;
+                base[stride + i] = 3 * u * u * t;
+                base[2 * stride + i] = 3 * u * t * t;
+                base[3 * stride + i] = t * t * t;
+            }
+            return *entry;
         }
+    }
+
+    std::vector<float> genCubicBezierCurve(int numPoints, const float* p0, const float* p1, const float* p2, const float* p3)
+    {
+        std::vector<float> points(2 * (numPoints + 1));
+        genCubicBezierCurve(numPoints, p0, p1, p2, p3, points.data());
         return points;
     }
-    std::vector<float> genCrosses(const std::vector<std::vector<float>>& points)
+    void genCubicBezierCurve(int numPoints, const float* p0, const float* p1, const float* p2, const float* p3, float* out)
     {
-        std::vector<float> returnPoints;
-        for (std::vector<float> p : points)
+        // (numPoints + 1) x 4 basis times the 4 x 2 control points
+        const BernsteinBasis& basis = bernsteinBasis(numPoints);
+        const float* b0 = basis.weights[0];
+        const float* b1 = basis.weights[1];
+        const float* b2 = basis.weights[2];
+        const float* b3 = basis.weights[3];
+        for (int i = 0; i <= numPoints; i++)
         {
+            out[2 * i] = b0[i] * p0[0] + b1[i] * p1[0] + b2[i] * p2[0] + b3[i] * p3[0];
+            out[2 * i + 1] = b0[i] * p0[1] + b1[i] * p1[1] + b2[i] * p2[1] + b3[i] * p3[1];
+        }
+    }
+    void genRationalCubicCurve(int numPoints, const float* c, float* out)
+    {
+        const BernsteinBasis& basis = bernsteinBasis(numPoints);
+        const float* b0 = basis.weights[0];
+        const float* b1 = basis.weights[1];
+        const float* b2 = basis.weights[2];
+        const float* b3 = basis.weights[3];
+        for (int i = 0; i <= numPoints; i++)
+        {
+            float w = b0[i] * c[2] + b1[i] * c[5] + b2[i] * c[8] + b3[i] * c[11];
+            out[2 * i] = (b0[i] * c[0] + b1[i] * c[3] + b2[i] * c[6] + b3[i] * c[9]) / w;
+            out[2 * i + 1] = (b0[i] * c[1] + b1[i] * c[4] + b2[i] * c[7] + b3[i] * c[10]) / w;
+        }
+    }
+    std::vector<float> genCrosses(const std::vector<float>& points, float size)
+    {
+        std::vector<float> returnPoints(4 * (points.size() / 2 * 2));
+        genCrosses(points.data(), points.size() / 2, size, returnPoints.data());
+        return returnPoints;
+    }
+    void genCrosses(const float* points, int pointCount, float size, float* out)
+    {
+        for (int i = 0; i < pointCount; i++)
+        {
+            const float* p = &points[2 * i];
+            float* cross = &out[8 * i];
             // create coordinates for cross-stroke drawing
-            for (int i = 0; i < points.size(); i++)
+            cross[0] = p[0] - size;
+            cross[1] = p[1] - size;
+            cross[2] = p[0] + size;
+            cross[3] = p[1] + size;
+            cross[4] = p[0] - size;
+            cross[5] = p[1] + size;
+            cross[6] = p[0] + size;
+            cross[7] = p[1] - size;
+        }
+    }
+    int cubicSampleCount(const float* c, float pixelsPerUnit, float tolerance)
+    {
+        // largest second difference of the control polygon bounds the curvature
+        float ax = c[0] - 2 * c[2] + c[4], ay = c[1] - 2 * c[3] + c[5];
+        float bx = c[2] - 2 * c[4] + c[6], by = c[3] - 2 * c[5] + c[7];
+        float m = std::sqrt(std::max(ax * ax + ay * ay, bx * bx + by * by)) * pixelsPerUnit;
+        // n(n - 1) / 8 = 3 / 4 for cubics
+        int n = (int)std::ceil(std::sqrt(0.75f * m / tolerance));
+        return std::min(std::max(n, 1), MAX_CURVE_SAMPLES);
+    }
+    void splitCubic(const float* c, float t, float* left, float* right)
+    {
+        // de Casteljau
+        for (int k = 0; k < 2; k++)
+        {
+            float p01 = c[k] + (c[2 + k] - c[k]) * t;
+            float p12 = c[2 + k] + (c[4 + k] - c[2 + k]) * t;
+            float p23 = c[4 + k] + (c[6 + k] - c[4 + k]) * t;
+            float p012 = p01 + (p12 - p01) * t;
+            float p123 = p12 + (p23 - p12) * t;
+            float p0123 = p012 + (p123 - p012) * t;
+            left[k] = c[k];
+            left[2 + k] = p01;
+            left[4 + k] = p012;
+            left[6 + k] = p0123;
+            right[k] = p0123;
+            right[2 + k] = p123;
+            right[4 + k] = p23;
+            right[6 + k] = c[6 + k];
+        }
+    }
+
+    void subCubic(const float* c, float t0, float t1, float* out)
+    {
+        float right[8], unused[8];
+        splitCubic(c, t0, unused, right);
+        // t1 relative to the part that is left after cutting at t0
+        float t = t0 < 1.0f ? (t1 - t0) / (1.0f - t0) : 0.0f;
+        splitCubic(right, t, out, unused);
+    }
+
+    namespace
+    {
+        template <class Intervals>
+        void clipInto(const float* controls, float left, float right, float bottom, float top, Intervals& intervals)
+        {
+            struct Piece
+            {
+                float c[8];
+                float t0, t1;
+                int depth;
+            };
+            // depth first, right half pushed first, so intervals come out in order of t
+            Piece stack[MAX_CLIP_DEPTH + 2];
+            std::copy(controls, controls + 8, stack[0].c);
+            stack[0].t0 = 0.0f;
+            stack[0].t1 = 1.0f;
+            stack[0].depth = 0;
+            int stackSize = 1;
+            while (stackSize > 0)
             {
-                returnPoints.push_back((p)[0] - 0.02);
-                returnPoints.push_back((p)[1] - 0.02);
-                returnPoints.push_back((p)[0] + 0.02);
-                returnPoints.push_back((p)[1] + 0.02);
-                returnPoints.push_back((p)[0] - 0.02);
-                returnPoints.push_back((p)[1] + 0.02);
-                returnPoints.push_back((p)[0] + 0.02);
-                returnPoints.push_back((p)[1] - 0.02);
+                Piece piece = stack[--stackSize];
+                const float* c = piece.c;
+                float minX = std::min(std::min(c[0], c[2]), std::min(c[4], c[6]));
+                float maxX = std::max(std::max(c[0], c[2]), std::max(c[4], c[6]));
+                float minY = std::min(std::min(c[1], c[3]), std::min(c[5], c[7]));
+                float maxY = std::max(std::max(c[1], c[3]), std::max(c[5], c[7]));
+                bool outside = maxX < left || minX > right || maxY < bottom || minY > top;
+                bool inside = minX >= left && maxX <= right && minY >= bottom && maxY <= top;
+                if (outside || inside || piece.depth >= MAX_CLIP_DEPTH)
+                {
+                    bool visible = !outside;
+                    // visible neighbours are merged, hidden ones are kept apart so each chord stays inside its own hull
+                    if (visible && !intervals.empty() && intervals.back().visible)
+                    {
+                        intervals.back().t1 = piece.t1;
+                    }
+                    else
+                    {
+                        ParamInterval interval = { piece.t0, piece.t1, visible };
+                        intervals.push_back(interval);
+                    }
+                    continue;
+                }
+                Piece first, second;
+                splitCubic(c, 0.5f, first.c, second.c);
+                float mid = 0.5f * (piece.t0 + piece.t1);
+                first.t0 = piece.t0;
+                first.t1 = mid;
+                second.t0 = mid;
+                second.t1 = piece.t1;
+                first.depth = second.depth = piece.depth + 1;
+                stack[stackSize++] = second;
+                stack[stackSize++] = first;
             }
         }
-        return returnPoints;
     }
-    //temporary
-    std::vector<float> genLagrangeCurve(int numPoints, const std::vector<std::vector<float>>& points)
+
+    std::vector<ParamInterval> clipCubicToRect(const float* controls, float left, float right, float bottom, float top)
+    {
+        std::vector<ParamInterval> intervals;
+        clipInto(controls, left, right, bottom, top, intervals);
+        return intervals;
+    }
+
+    void clipCubicToRect(const float* controls, float left, float right, float bottom, float top, ArenaVector<ParamInterval>& intervals)
+    {
+        clipInto(controls, left, right, bottom, top, intervals);
+    }
+
+    std::vector<float> genLagrangeCurve(int numPoints, const float* points, int pointCount)
+    {
+        if (pointCount <= 0) return std::vector<float>();
+        NewtonPolynomial polynomial;
+        polynomial.assign(points, pointCount);
+        std::vector<float> curve(2 * (numPoints + 1));
+        polynomial.sample(numPoints, curve.data());
+        return curve;
+    }
+
+    bool isSpline(CurveType type)
+    {
+        return type == CurveType::CatmullRom || type == CurveType::Centripetal || type == CurveType::Cardinal;
+    }
+
+    void splineSegmentToCubic(CurveType type, const float* points, int pointCount, int segment, float* out)
+    {
+        // P1 and P2 are the ends of the segment, P0 and P3 shape its tangents
+        float p[8];
+        for (int k = 0; k < 2; k++)
+        {
+            p[2 + k] = points[2 * segment + k];
+            p[4 + k] = points[2 * (segment + 1) + k];
+            p[k] = segment > 0 ? points[2 * (segment - 1) + k] : 2 * p[2 + k] - p[4 + k];
+            p[6 + k] = segment + 2 < pointCount ? points[2 * (segment + 2) + k] : 2 * p[4 + k] - p[2 + k];
+        }
+        // knot intervals are |Pi+1 - Pi|^alpha, the uniform types use 1
+        float alpha = type == CurveType::Centripetal ? 0.5f : 0.0f;
+        float scale = type == CurveType::Cardinal ? 1.0f - CARDINAL_TENSION : 1.0f;
+        float d[3];
+        for (int i = 0; i < 3; i++)
+        {
+            float dx = p[2 * i + 2] - p[2 * i];
+            float dy = p[2 * i + 3] - p[2 * i + 1];
+            d[i] = std::pow(dx * dx + dy * dy, 0.5f * alpha);
+            // coincident points would divide by zero, their differences vanish anyway
+            if (d[i] < 1e-6f) d[i] = 1e-6f;
+        }
+        for (int k = 0; k < 2; k++)
+        {
+            // tangents at P1 and P2 in knot units, then scaled to the segment's [0 : 1]
+            float m1 = (p[2 + k] - p[k]) / d[0] - (p[4 + k] - p[k]) / (d[0] + d[1]) + (p[4 + k] - p[2 + k]) / d[1];
+            float m2 = (p[4 + k] - p[2 + k]) / d[1] - (p[6 + k] - p[2 + k]) / (d[1] + d[2]) + (p[6 + k] - p[4 + k]) / d[2];
+            m1 *= scale * d[1];
+            m2 *= scale * d[1];
+            out[k] = p[2 + k];
+            out[2 + k] = p[2 + k] + m1 / 3;
+            out[4 + k] = p[4 + k] - m2 / 3;
+            out[6 + k] = p[4 + k];
+        }
+    }
+
+    std::vector<float> splineToCubics(CurveType type, const float* points, int pointCount)
     {
-        return std::vector<float>();
+        if (pointCount < 2) return std::vector<float>(points, points + 2 * std::max(pointCount, 0));
+        std::vector<float> controls(2 * (3 * (pointCount - 1) + 1));
+        for (int segment = 0; segment < pointCount - 1; segment++)
+            splineSegmentToCubic(type, points, pointCount, segment, &controls[6 * segment]);
+        return controls;
     }
-}
\ No newline at end of file
+}
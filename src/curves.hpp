@@ -1,16 +1,67 @@
 #pragma once
 
+#include "frame_arena.hpp"
+
 #include <vector>
 #include <cmath>
 
 namespace curves
 {
+    // upper bound for the adaptive sample counts
+    const int MAX_CURVE_SAMPLES = 1024;
+    // how often a cubic may be halved while clipping it to the view
+    const int MAX_CLIP_DEPTH = 16;
+
+    // part [t0 : t1] of a curve and whether it may show up inside the clip rectangle
+    struct ParamInterval
+    {
+        float t0, t1;
+        bool visible;
+    };
+
     enum class CurveType
     {
+        // piecewise, consecutive segments share their end points
         CubicBezier,
-        Lagrange
+        Lagrange,
+        // cubic splines through every point, tangents from the neighbours (uniform knots)
+        CatmullRom,
+        // same with knots spaced by the square root of the chord lengths, never loops or cusps
+        Centripetal,
+        // Catmull-Rom with the tangents shortened by CARDINAL_TENSION
+        Cardinal,
+        // rational B-spline, its degree, knots and weights are kept next to the points (see nurbs.hpp)
+        Nurbs
     };
-    std::vector<float> genCubicBezierCurve(int numPoints, const std::vector<float>& p0, const std::vector<float>& p1, const std::vector<float>& p2, const std::vector<float>& p3);
-    std::vector<float> genLagrangeCurve(int numPoints, const std::vector<std::vector<float>>& points);
-    std::vector<float> genCrosses(const std::vector<std::vector<float>>& points);
+    // 0 is Catmull-Rom, 1 gives straight lines between the points
+    const float CARDINAL_TENSION = 0.5f;
+    // curve types whose segment i only depends on the points i - 1 to i + 2
+    bool isSpline(CurveType type);
+    // points are stored flat as x, y pairs
+    std::vector<float> genCubicBezierCurve(int numPoints, const float* p0, const float* p1, const float* p2, const float* p3);
+    // same, written to out (2 * (numPoints + 1) floats) so callers can sample straight into their buffers
+    void genCubicBezierCurve(int numPoints, const float* p0, const float* p1, const float* p2, const float* p3, float* out);
+    // same for a rational cubic, controls are 4 weighted points (w x, w y, w)
+    void genRationalCubicCurve(int numPoints, const float* controls, float* out);
+    // numPoints + 1 vertices of the polynomial through the points, at t = 0, 1, ..., pointCount - 1
+    std::vector<float> genLagrangeCurve(int numPoints, const float* points, int pointCount);
+    // cubic Bezier controls (8 floats) of the spline segment between points segment and segment + 1,
+    // the missing neighbours at the ends are mirrored
+    void splineSegmentToCubic(CurveType type, const float* points, int pointCount, int segment, float* out);
+    // the whole spline as 3 * (pointCount - 1) + 1 piecewise cubic control points
+    std::vector<float> splineToCubics(CurveType type, const float* points, int pointCount);
+    // 4 vertices (two GL_LINES) per point, size is half the width of a cross
+    std::vector<float> genCrosses(const std::vector<float>& points, float size);
+    // 8 floats per point to out
+    void genCrosses(const float* points, int pointCount, float size, float* out);
+    // samples a cubic (8 floats) needs to stay within tolerance pixels of the curve (Wang's formula)
+    int cubicSampleCount(const float* controls, float pixelsPerUnit, float tolerance);
+    // splits the cubic at t into two cubics that share controls[6..7] of the left half
+    void splitCubic(const float* controls, float t, float* left, float* right);
+    // control points of the part [t0 : t1] of a cubic
+    void subCubic(const float* controls, float t0, float t1, float* out);
+    // splits [0 : 1] into intervals that are either inside the rectangle or have their whole hull outside of it
+    std::vector<ParamInterval> clipCubicToRect(const float* controls, float left, float right, float bottom, float top);
+    // same, appended to per-frame scratch memory
+    void clipCubicToRect(const float* controls, float left, float right, float bottom, float top, ArenaVector<ParamInterval>& intervals);
 }
\ No newline at end of file
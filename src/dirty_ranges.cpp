@@ -0,0 +1,137 @@
+#include "dirty_ranges.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace curves
+{
+    // changed sections are compared in blocks of this many bytes
+    const size_t DIFF_BLOCK_BYTES = 256;
+    // uploads closer than this are sent as one, the unchanged bytes between them go along
+    const size_t UPLOAD_MERGE_GAP_BYTES = 1024;
+
+    DirtyRangeTracker::DirtyRangeTracker()
+    {
+        valid = false;
+    }
+
+    void DirtyRangeTracker::reset()
+    {
+        valid = false;
+        shadow.clear();
+        shadowSections.clear();
+    }
+
+    void DirtyRangeTracker::update(const void* data, size_t bytes, const std::vector<BufferSection>& sections, size_t kept)
+    {
+        const unsigned char* in = (const unsigned char*)data;
+        uploads.clear();
+        copies.clear();
+        if (!valid || kept > shadow.size() || kept > bytes) kept = 0;
+#ifdef DEBUG
+        if (kept > 0 && std::memcmp(shadow.data(), in, kept) != 0)
+            std::cerr << "ERROR::DIRTY_RANGES::KEPT_BYTES_CHANGED" << std::endl;
+#endif
+        if (!valid)
+        {
+            add_upload(0, bytes);
+        }
+        else
+        {
+            // both section lists ascend by key, so they are walked side by side
+            size_t old = 0;
+            for (const BufferSection& section : sections)
+            {
+                if (section.offset + section.bytes <= kept) continue;
+                while (old < shadowSections.size() && shadowSections[old].key < section.key) old++;
+                if (old == shadowSections.size() || shadowSections[old].key != section.key
+                    || shadowSections[old].bytes != section.bytes)
+                {
+                    // new, or grown or shrunk in place
+                    add_upload(section.offset, section.bytes);
+                    continue;
+                }
+                diff(in, shadowSections[old].offset, section.offset, section.bytes);
+            }
+        }
+        // only what follows the kept bytes can have changed
+        shadow.resize(bytes);
+        if (bytes > kept) std::memcpy(&shadow[kept], in + kept, bytes - kept);
+        shadowSections = sections;
+        valid = true;
+    }
+
+    void DirtyRangeTracker::diff(const unsigned char* data, size_t from, size_t to, size_t bytes)
+    {
+        // the first and last blocks that differ, everything else is the same
+        size_t first = bytes, last = 0;
+        for (size_t block = 0; block < bytes; block += DIFF_BLOCK_BYTES)
+        {
+            size_t size = std::min(DIFF_BLOCK_BYTES, bytes - block);
+            if (std::memcmp(&shadow[from + block], &data[to + block], size) == 0) continue;
+            if (first == bytes) first = block;
+            last = block + size;
+            // a section that moved keeps its unchanged blocks by copying them
+            if (from == to) add_upload(to + block, size);
+        }
+        if (from == to) return;
+        if (first == bytes)
+        {
+            add_copy(from, to, bytes);
+            return;
+        }
+        // moved and changed: copy what is in front of and behind the change, upload the middle
+        if (first > 0) add_copy(from, to, first);
+        add_upload(to + first, last - first);
+        if (last < bytes) add_copy(from + last, to + last, bytes - last);
+    }
+
+    void DirtyRangeTracker::add_upload(size_t offset, size_t bytes)
+    {
+        if (bytes == 0) return;
+        if (!uploads.empty() && offset <= uploads.back().offset + uploads.back().bytes + UPLOAD_MERGE_GAP_BYTES
+            && offset >= uploads.back().offset)
+        {
+            uploads.back().bytes = std::max(uploads.back().bytes, offset + bytes - uploads.back().offset);
+            return;
+        }
+        ByteRange range = { offset, bytes };
+        uploads.push_back(range);
+    }
+
+    void DirtyRangeTracker::add_copy(size_t from, size_t to, size_t bytes)
+    {
+        if (bytes == 0) return;
+        // sections that moved by the same amount are usually neighbours
+        if (!copies.empty())
+        {
+            ByteCopy& back = copies.back();
+            if (back.from + back.bytes == from && back.to + back.bytes == to)
+            {
+                back.bytes += bytes;
+                return;
+            }
+        }
+        ByteCopy copy = { from, to, bytes };
+        copies.push_back(copy);
+    }
+
+    const std::vector<ByteRange>& DirtyRangeTracker::get_uploads() const
+    {
+        return uploads;
+    }
+
+    const std::vector<ByteCopy>& DirtyRangeTracker::get_copies() const
+    {
+        return copies;
+    }
+
+    size_t DirtyRangeTracker::upload_bytes() const
+    {
+        size_t total = 0;
+        for (const ByteRange& range : uploads)
+            total += range.bytes;
+        return total;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace curves
+{
+    // bytes [offset : offset + bytes) of a buffer
+    struct ByteRange
+    {
+        size_t offset, bytes;
+    };
+
+    // unchanged bytes that moved from one offset to another, both in the same buffer
+    struct ByteCopy
+    {
+        size_t from, to, bytes;
+    };
+
+    // A part of a buffer that keeps its identity from one update to the next, like the vertices
+    // of one curve. Keys have to ascend through a buffer.
+    struct BufferSection
+    {
+        uint64_t key;
+        size_t offset, bytes;
+    };
+
+    // Works out what has to be sent to a GPU buffer to turn its last contents into new ones.
+    // Sections found in both versions are compared byte by byte. Unchanged ones that only
+    // shifted (because something in front of them grew or shrank) become copies, changed
+    // ones are narrowed down to the blocks that differ. Nearby uploads are merged into one.
+    // The copies have to be done before the uploads and all read the old contents.
+    class DirtyRangeTracker
+    {
+    public:
+        DirtyRangeTracker();
+        // forgets the last contents, for when the buffer lost them, the next update uploads everything
+        void reset();
+        // sections have to cover data back to back. The first kept bytes are known to be the same as in the
+        // last update (with the same sections), they aren't compared again.
+        void update(const void* data, size_t bytes, const std::vector<BufferSection>& sections, size_t kept);
+        const std::vector<ByteRange>& get_uploads() const;
+        const std::vector<ByteCopy>& get_copies() const;
+        // sum of get_uploads
+        size_t upload_bytes() const;
+    private:
+        void add_upload(size_t offset, size_t bytes);
+        void add_copy(size_t from, size_t to, size_t bytes);
+        // uploads the blocks of a section that differ from its old contents at from
+        void diff(const unsigned char* data, size_t from, size_t to, size_t bytes);
+        bool valid;
+        std::vector<unsigned char> shadow;
+        std::vector<BufferSection> shadowSections;
+        std::vector<ByteRange> uploads;
+        std::vector<ByteCopy> copies;
+    };
+}
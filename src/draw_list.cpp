@@ -0,0 +1,91 @@
+#include "draw_list.hpp"
+
+#include <algorithm>
+
+namespace curves
+{
+    const uint32_t DrawList::RESTART_INDEX;
+
+    DrawList::DrawList()
+    {
+        keptIndices = keptRanges = keptBatches = 0;
+    }
+
+    void DrawList::clear()
+    {
+        indices.clear();
+        ranges.clear();
+        batches.clear();
+        keptIndices = keptRanges = keptBatches = 0;
+    }
+
+    void DrawList::keep()
+    {
+        keptIndices = indices.size();
+        keptRanges = ranges.size();
+        keptBatches = batches.size();
+        if (keptRanges > 0) keptRange = ranges.back();
+        if (keptBatches > 0) keptBatch = batches.back();
+    }
+
+    void DrawList::rewind()
+    {
+        indices.resize(keptIndices);
+        ranges.resize(keptRanges);
+        batches.resize(keptBatches);
+        if (keptRanges > 0) ranges.back() = keptRange;
+        if (keptBatches > 0) batches.back() = keptBatch;
+    }
+
+    void DrawList::add_strip(DrawStyle style, int curve, int firstVertex, int count)
+    {
+        if (count <= 0) return;
+        int firstIndex = indices.size();
+        for (int i = 0; i < count; i++)
+            indices.push_back(firstVertex + i);
+        indices.push_back(RESTART_INDEX);
+        int added = count + 1;
+        if (!ranges.empty() && ranges.back().style == style && ranges.back().curve == curve)
+        {
+            ranges.back().indexCount += added;
+            extend(ranges.back(), firstVertex, count);
+        }
+        else
+        {
+            DrawRange range = { style, curve, firstIndex, added, firstVertex, count };
+            ranges.push_back(range);
+        }
+        if (!batches.empty() && batches.back().style == style)
+        {
+            batches.back().indexCount += added;
+            extend(batches.back(), firstVertex, count);
+        }
+        else
+        {
+            DrawRange batch = { style, -1, firstIndex, added, firstVertex, count };
+            batches.push_back(batch);
+        }
+    }
+
+    void DrawList::extend(DrawRange& range, int firstVertex, int count)
+    {
+        int end = std::max(range.firstVertex + range.vertexCount, firstVertex + count);
+        range.firstVertex = std::min(range.firstVertex, firstVertex);
+        range.vertexCount = end - range.firstVertex;
+    }
+
+    const std::vector<uint32_t>& DrawList::get_indices() const
+    {
+        return indices;
+    }
+
+    const std::vector<DrawRange>& DrawList::get_ranges() const
+    {
+        return ranges;
+    }
+
+    const std::vector<DrawRange>& DrawList::get_batches() const
+    {
+        return batches;
+    }
+}
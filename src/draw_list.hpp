@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace curves
+{
+    enum class DrawStyle
+    {
+        Curve,
+        Marker
+    };
+
+    // indices [firstIndex : firstIndex + indexCount) of a draw list, restart indices included
+    struct DrawRange
+    {
+        DrawStyle style;
+        // -1 for batches, which span every curve of their style
+        int curve;
+        int firstIndex, indexCount;
+        // the vertices its strips use lie in [firstVertex : firstVertex + vertexCount)
+        int firstVertex, vertexCount;
+    };
+
+    // Line strips of all curves packed into one index stream, separated by RESTART_INDEX,
+    // so every run of strips of one style goes out with a single indexed draw.
+    // The strips of a curve and style have to be added one after another.
+    class DrawList
+    {
+    public:
+        DrawList();
+        static const uint32_t RESTART_INDEX = 0xFFFFFFFFu;
+        void clear();
+        // vertices [firstVertex : firstVertex + count) as one strip
+        void add_strip(DrawStyle style, int curve, int firstVertex, int count);
+        // remembers the strips added so far, rewind drops everything added after them
+        void keep();
+        void rewind();
+        const std::vector<uint32_t>& get_indices() const;
+        // one range per curve and style, in the order they were added
+        const std::vector<DrawRange>& get_ranges() const;
+        // one range per run of a style
+        const std::vector<DrawRange>& get_batches() const;
+    private:
+        // grows range to take in vertices [firstVertex : firstVertex + count)
+        static void extend(DrawRange& range, int firstVertex, int count);
+        std::vector<uint32_t> indices;
+        std::vector<DrawRange> ranges;
+        std::vector<DrawRange> batches;
+        // sizes at the last keep, and the last range and batch then (later strips may grow them)
+        size_t keptIndices, keptRanges, keptBatches;
+        DrawRange keptRange, keptBatch;
+    };
+}
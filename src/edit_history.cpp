@@ -0,0 +1,159 @@
+#include "edit_history.hpp"
+
+#include <algorithm>
+
+namespace curves
+{
+    const size_t HISTORY_CHUNK_POINTS = 1024;
+    // oldest steps are dropped beyond this
+    const size_t MAX_UNDO_STEPS = 1000;
+
+    EditHistory::EditHistory()
+    {
+        openWrites = 0;
+    }
+
+    void EditHistory::clear()
+    {
+        undoSteps.clear();
+        redoSteps.clear();
+        pending.clear();
+        openWrites = 0;
+        latest.clear();
+    }
+
+    void EditHistory::begin()
+    {
+        pending.clear();
+        openWrites = 0;
+    }
+
+    void EditHistory::touch(const Scene& scene, size_t point)
+    {
+        size_t chunk = point / HISTORY_CHUNK_POINTS;
+        for (size_t i = openWrites; i < pending.size(); i++)
+            if (pending[i].chunk == chunk) return;
+        Operation write;
+        write.chunk = chunk;
+        std::unordered_map<size_t, Chunk>::const_iterator known = latest.find(chunk);
+        write.before = known != latest.end() ? known->second : copy_chunk(scene, chunk);
+        write.curve = -1;
+        write.at = write.pointCount = 0;
+        pending.push_back(write);
+    }
+
+    void EditHistory::insert(Scene& scene, int curve, size_t at, const float* points, size_t pointCount)
+    {
+        // the chunk writes so far refer to the boundaries before the insert
+        finish_writes(scene);
+        scene.insert_points(curve, at, points, pointCount);
+        Operation op;
+        op.chunk = 0;
+        op.curve = curve;
+        op.at = at;
+        op.pointCount = pointCount;
+        op.inserted.assign(points, points + 2 * pointCount);
+        pending.push_back(op);
+        openWrites = pending.size();
+        latest.clear();
+    }
+
+    void EditHistory::commit(const Scene& scene)
+    {
+        finish_writes(scene);
+        if (pending.empty()) return;
+        undoSteps.push_back(Step());
+        undoSteps.back().swap(pending);
+        if (undoSteps.size() > MAX_UNDO_STEPS) undoSteps.pop_front();
+        redoSteps.clear();
+        openWrites = 0;
+    }
+
+    bool EditHistory::can_undo() const
+    {
+        return !undoSteps.empty();
+    }
+
+    bool EditHistory::can_redo() const
+    {
+        return !redoSteps.empty();
+    }
+
+    bool EditHistory::undo(Scene& scene, std::vector<PointChange>& changes, bool& structural)
+    {
+        if (undoSteps.empty()) return false;
+        apply(scene, undoSteps.back(), false, changes, structural);
+        redoSteps.push_back(Step());
+        redoSteps.back().swap(undoSteps.back());
+        undoSteps.pop_back();
+        return true;
+    }
+
+    bool EditHistory::redo(Scene& scene, std::vector<PointChange>& changes, bool& structural)
+    {
+        if (redoSteps.empty()) return false;
+        apply(scene, redoSteps.back(), true, changes, structural);
+        undoSteps.push_back(Step());
+        undoSteps.back().swap(redoSteps.back());
+        redoSteps.pop_back();
+        return true;
+    }
+
+    EditHistory::Chunk EditHistory::copy_chunk(const Scene& scene, size_t chunk) const
+    {
+        const PointArray& points = scene.points();
+        size_t first = 2 * chunk * HISTORY_CHUNK_POINTS;
+        size_t last = std::min(first + 2 * HISTORY_CHUNK_POINTS, points.size());
+        return Chunk(new std::vector<float>(points.data() + first, points.data() + last));
+    }
+
+    void EditHistory::finish_writes(const Scene& scene)
+    {
+        for (size_t i = openWrites; i < pending.size(); i++)
+        {
+            pending[i].after = copy_chunk(scene, pending[i].chunk);
+            latest[pending[i].chunk] = pending[i].after;
+        }
+        openWrites = pending.size();
+    }
+
+    void EditHistory::write_chunk(Scene& scene, size_t chunk, const Chunk& data, std::vector<PointChange>& changes)
+    {
+        PointArray& points = scene.points();
+        size_t first = 2 * chunk * HISTORY_CHUNK_POINTS;
+        for (size_t i = 0; i + 1 < data->size(); i += 2)
+        {
+            float x = (*data)[i], y = (*data)[i + 1];
+            if (points[first + i] == x && points[first + i + 1] == y) continue;
+            PointChange change = { (first + i) / 2, points[first + i], points[first + i + 1] };
+            changes.push_back(change);
+            points[first + i] = x;
+            points[first + i + 1] = y;
+        }
+        latest[chunk] = data;
+    }
+
+    bool EditHistory::apply(Scene& scene, const Step& step, bool forward, std::vector<PointChange>& changes, bool& structural)
+    {
+        changes.clear();
+        structural = false;
+        for (size_t n = 0; n < step.size(); n++)
+        {
+            const Operation& op = step[forward ? n : step.size() - 1 - n];
+            if (op.pointCount == 0)
+            {
+                write_chunk(scene, op.chunk, forward ? op.after : op.before, changes);
+                continue;
+            }
+            if (forward)
+                scene.insert_points(op.curve, op.at, op.inserted.data(), op.pointCount);
+            else
+                scene.erase_points(op.curve, op.at, op.pointCount);
+            structural = true;
+            latest.clear();
+        }
+        // point indices from before an insert or erase don't mean anything anymore
+        if (structural) changes.clear();
+        return true;
+    }
+}
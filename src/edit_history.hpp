@@ -0,0 +1,67 @@
+#pragma once
+
+#include "scene.hpp"
+
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace curves
+{
+    // a control point whose value was replaced by an undo or redo
+    struct PointChange
+    {
+        size_t point;
+        float oldX, oldY;
+    };
+
+    // Undo/redo for the control points of a Scene.
+    // The points are split into chunks of HISTORY_CHUNK_POINTS. A step keeps the chunks it
+    // changed (before and after, shared with the neighbouring steps) and the points it inserted,
+    // so memory grows with the edits and undo/redo only touch the changed chunks.
+    // Inserts shift the chunks behind them, so they are replayed as inserts and erases.
+    class EditHistory
+    {
+    public:
+        EditHistory();
+        void clear();
+        // starts collecting one undo step
+        void begin();
+        // has to be called before the point is changed in place
+        void touch(const Scene& scene, size_t point);
+        // inserts the points into the scene and records it
+        void insert(Scene& scene, int curve, size_t at, const float* points, size_t pointCount);
+        // closes the step, steps without changes are dropped
+        void commit(const Scene& scene);
+        bool can_undo() const;
+        bool can_redo() const;
+        // structural is set if points were inserted or erased, otherwise changes lists the moved points
+        bool undo(Scene& scene, std::vector<PointChange>& changes, bool& structural);
+        bool redo(Scene& scene, std::vector<PointChange>& changes, bool& structural);
+    private:
+        typedef std::shared_ptr<const std::vector<float>> Chunk;
+        struct Operation
+        {
+            // chunk writes have pointCount 0
+            size_t chunk;
+            Chunk before, after;
+            int curve;
+            size_t at, pointCount;
+            std::vector<float> inserted;
+        };
+        typedef std::vector<Operation> Step;
+        Chunk copy_chunk(const Scene& scene, size_t chunk) const;
+        void finish_writes(const Scene& scene);
+        void write_chunk(Scene& scene, size_t chunk, const Chunk& data, std::vector<PointChange>& changes);
+        bool apply(Scene& scene, const Step& step, bool forward, std::vector<PointChange>& changes, bool& structural);
+        std::deque<Step> undoSteps;
+        std::vector<Step> redoSteps;
+        Step pending;
+        // chunk writes of pending that still wait for their after state start here
+        size_t openWrites;
+        // the current content of chunks that some step already holds, reused as the next step's before state.
+        // Only valid until an insert or erase moves the chunk boundaries.
+        std::unordered_map<size_t, Chunk> latest;
+    };
+}
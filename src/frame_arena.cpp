@@ -0,0 +1,77 @@
+#include "frame_arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace curves
+{
+    FrameArena::FrameArena(size_t initialBytes)
+    {
+        offset = 0;
+        usedBytes = 0;
+        add_block(std::max(initialBytes, (size_t)64));
+    }
+
+    FrameArena::~FrameArena()
+    {
+        for (const Block& block : blocks)
+            std::free(block.data);
+    }
+
+    void* FrameArena::allocate(size_t bytes, size_t alignment)
+    {
+        Block& block = blocks.back();
+        uintptr_t address = (uintptr_t)block.data + offset;
+        size_t padding = (alignment - address % alignment) % alignment;
+        if (offset + padding + bytes > block.size)
+        {
+            // a fresh block is aligned for anything, so no padding there
+            add_block(std::max(bytes, 2 * block.size));
+            padding = 0;
+        }
+        void* result = blocks.back().data + offset + padding;
+        offset += padding + bytes;
+        usedBytes += bytes;
+        return result;
+    }
+
+    void FrameArena::reset()
+    {
+        if (blocks.size() > 1)
+        {
+            // this frame didn't fit, make the next one fit into a single block
+            size_t total = capacity();
+            for (const Block& block : blocks)
+                std::free(block.data);
+            blocks.clear();
+            add_block(total);
+        }
+        offset = 0;
+        usedBytes = 0;
+    }
+
+    size_t FrameArena::used() const
+    {
+        return usedBytes;
+    }
+
+    size_t FrameArena::capacity() const
+    {
+        size_t total = 0;
+        for (const Block& block : blocks)
+            total += block.size;
+        return total;
+    }
+
+    void FrameArena::add_block(size_t bytes)
+    {
+        Block block;
+        block.data = static_cast<unsigned char*>(std::malloc(bytes));
+        if (block.data == NULL) throw std::bad_alloc();
+        block.size = bytes;
+        blocks.push_back(block);
+        offset = 0;
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace curves
+{
+    // Bump allocator for memory that only lives for one frame. Everything is released at once
+    // by reset(). When a frame needs more than one block, the next reset merges them into one,
+    // so after a few frames the arena stops calling malloc.
+    class FrameArena
+    {
+    public:
+        explicit FrameArena(size_t initialBytes = 1 << 16);
+        ~FrameArena();
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+        void* allocate(size_t bytes, size_t alignment);
+        void reset();
+        // bytes handed out since the last reset
+        size_t used() const;
+        size_t capacity() const;
+    private:
+        struct Block
+        {
+            unsigned char* data;
+            size_t size;
+        };
+        void add_block(size_t bytes);
+        std::vector<Block> blocks;
+        // offset into the last block
+        size_t offset;
+        size_t usedBytes;
+    };
+
+    // std allocator on top of a FrameArena, deallocate is a no-op
+    template <class T>
+    class ArenaAllocator
+    {
+    public:
+        typedef T value_type;
+        explicit ArenaAllocator(FrameArena& arena) : arena(&arena) {}
+        template <class U>
+        ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+        T* allocate(size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T))); }
+        void deallocate(T*, size_t) {}
+        template <class U>
+        bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+        template <class U>
+        bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+    private:
+        template <class U> friend class ArenaAllocator;
+        FrameArena* arena;
+    };
+
+    // has to be dropped (or at least not touched) before the arena is reset
+    template <class T>
+    using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+}
@@ -0,0 +1,122 @@
+#include "frame_encoder.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace curves
+{
+    FrameEncoder::FrameEncoder()
+    {
+        running = false;
+        stopping = false;
+        busy = 0;
+        written = failed = dropped = 0;
+    }
+
+    FrameEncoder::~FrameEncoder()
+    {
+        stop();
+    }
+
+    void FrameEncoder::start()
+    {
+        if (running) return;
+        stopping = false;
+        running = true;
+        // half of the cores, the render loop and the driver need the rest
+        unsigned count = std::min(MAX_ENCODER_THREADS, std::max(2u, std::thread::hardware_concurrency() / 2));
+        for (unsigned i = 0; i < count; i++)
+            workers.push_back(std::thread(&FrameEncoder::run, this));
+    }
+
+    void FrameEncoder::stop()
+    {
+        if (!running) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        queueChanged.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+        workers.clear();
+        running = false;
+    }
+
+    std::vector<unsigned char> FrameEncoder::take_buffer()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (spare.empty()) return std::vector<unsigned char>();
+        std::vector<unsigned char> buffer;
+        buffer.swap(spare.back());
+        spare.pop_back();
+        return buffer;
+    }
+
+    bool FrameEncoder::submit(EncodeJob job, bool mayDrop)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (mayDrop && queue.size() >= MAX_QUEUED_FRAMES)
+        {
+            // a gap in a recording is better than a render loop waiting for the disk
+            dropped++;
+            if (spare.size() < MAX_QUEUED_FRAMES) spare.push_back(std::move(job.pixels));
+            return false;
+        }
+        queueChanged.wait(lock, [this] { return queue.size() < MAX_QUEUED_FRAMES; });
+        queue.push_back(std::move(job));
+        lock.unlock();
+        queueChanged.notify_all();
+        return true;
+    }
+
+    void FrameEncoder::flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        queueChanged.wait(lock, [this] { return queue.empty() && busy == 0; });
+    }
+
+    size_t FrameEncoder::written_count()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return written;
+    }
+
+    size_t FrameEncoder::failed_count()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return failed;
+    }
+
+    size_t FrameEncoder::dropped_count()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return dropped;
+    }
+
+    void FrameEncoder::run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            queueChanged.wait(lock, [this] { return !queue.empty() || stopping; });
+            // stopping still writes everything that was queued
+            if (queue.empty()) return;
+            EncodeJob job = std::move(queue.front());
+            queue.pop_front();
+            busy++;
+            lock.unlock();
+            queueChanged.notify_all();
+            bool ok = saveImage(job.path, job.format, job.width, job.height, job.pixels.data(), job.bottomUp);
+            lock.lock();
+            busy--;
+            if (ok) written++;
+            else failed++;
+            // a few buffers are enough to keep recording without allocations
+            if (spare.size() < MAX_QUEUED_FRAMES) spare.push_back(std::move(job.pixels));
+            lock.unlock();
+            queueChanged.notify_all();
+            lock.lock();
+        }
+    }
+}
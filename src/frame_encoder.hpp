@@ -0,0 +1,68 @@
+#pragma once
+
+#include "image_file.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace curves
+{
+    // frames that may wait for the encoders, recorded frames beyond that are dropped
+    const size_t MAX_QUEUED_FRAMES = 8;
+    // threads writing images, each file is written by one of them
+    const unsigned MAX_ENCODER_THREADS = 4;
+
+    struct EncodeJob
+    {
+        std::string path;
+        ImageFormat format;
+        int width, height;
+        // rows bottom to top, as they come from the GPU
+        bool bottomUp;
+        std::vector<unsigned char> pixels;
+    };
+
+    // Writes images on threads of their own, the caller only hands the pixels over.
+    // Every job names its own file, so the workers can finish them in any order.
+    // Pixel buffers of written frames are kept for take_buffer, so recording doesn't
+    // allocate a new frame every frame.
+    class FrameEncoder
+    {
+    public:
+        FrameEncoder();
+        // writes what is still queued
+        ~FrameEncoder();
+        void start();
+        // writes what is queued and ends the threads
+        void stop();
+        // an empty buffer, recycled if one is free
+        std::vector<unsigned char> take_buffer();
+        // with MAX_QUEUED_FRAMES waiting already the encoders are falling behind: a job that may be
+        // dropped is then counted and thrown away (returns false), any other one waits for room
+        bool submit(EncodeJob job, bool mayDrop);
+        // waits until everything submitted so far is written
+        void flush();
+        // images written, images that failed and images dropped so far
+        size_t written_count();
+        size_t failed_count();
+        size_t dropped_count();
+    private:
+        void run();
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        // signalled when a job is queued or taken, or when stopping
+        std::condition_variable queueChanged;
+        std::deque<EncodeJob> queue;
+        std::vector<std::vector<unsigned char>> spare;
+        bool running;
+        bool stopping;
+        // jobs the workers took that aren't written yet
+        int busy;
+        size_t written, failed, dropped;
+    };
+}
@@ -0,0 +1,182 @@
+#include "frame_exporter.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+namespace curves
+{
+    // how long collect(true) waits for a fence at a time
+    const GLuint64 READBACK_WAIT_NS = 100000000;
+
+    FrameExporter::FrameExporter()
+    {
+        for (Readback& slot : ring)
+        {
+            slot.buffer = 0;
+            slot.capacity = 0;
+            slot.fence = 0;
+            slot.width = slot.height = 0;
+            slot.format = ImageFormat::Png;
+            slot.recorded = false;
+        }
+        oldest = pending = 0;
+        captureRequested = false;
+        captureFormat = ImageFormat::Png;
+        recording = false;
+        recordFormat = ImageFormat::Png;
+        recordedFrames = 0;
+        droppedBefore = 0;
+    }
+
+    bool FrameExporter::init()
+    {
+        for (Readback& slot : ring)
+            glGenBuffers(1, &slot.buffer);
+        encoder.start();
+        return true;
+    }
+
+    void FrameExporter::destroy()
+    {
+        finish();
+        encoder.stop();
+        for (Readback& slot : ring)
+        {
+            glDeleteBuffers(1, &slot.buffer);
+            slot.buffer = 0;
+            slot.capacity = 0;
+        }
+    }
+
+    void FrameExporter::capture(const std::string& path, ImageFormat format)
+    {
+        captureRequested = true;
+        capturePath = path;
+        captureFormat = format;
+    }
+
+    void FrameExporter::start_recording(const std::string& prefix, ImageFormat format)
+    {
+        recording = true;
+        recordPrefix = prefix;
+        recordFormat = format;
+        recordedFrames = 0;
+        droppedBefore = encoder.dropped_count();
+    }
+
+    void FrameExporter::stop_recording()
+    {
+        recording = false;
+    }
+
+    bool FrameExporter::is_recording() const
+    {
+        return recording;
+    }
+
+    size_t FrameExporter::dropped_frames()
+    {
+        return encoder.dropped_count() - droppedBefore;
+    }
+
+    void FrameExporter::end_frame()
+    {
+        while (collect(false)) {}
+        if (captureRequested)
+        {
+            read_frame(capturePath, captureFormat, false);
+            captureRequested = false;
+        }
+        if (recording)
+        {
+            char number[16];
+            std::snprintf(number, sizeof(number), "%05d", recordedFrames++);
+            read_frame(recordPrefix + number + imageExtension(recordFormat), recordFormat, true);
+        }
+    }
+
+    void FrameExporter::finish()
+    {
+        while (pending > 0)
+            collect(true);
+        encoder.flush();
+    }
+
+    void FrameExporter::read_frame(const std::string& path, ImageFormat format, bool recorded)
+    {
+        // the GPU is a whole ring behind, only then does the loop wait for it
+        if (pending == READBACK_RING_SIZE) collect(true);
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        Readback& slot = ring[(oldest + pending) % READBACK_RING_SIZE];
+        slot.width = viewport[2];
+        slot.height = viewport[3];
+        slot.path = path;
+        slot.format = format;
+        slot.recorded = recorded;
+        GLsizeiptr bytes = (GLsizeiptr)slot.width * slot.height * 4;
+        GLint readFramebuffer;
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glReadBuffer(GL_BACK);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        if (bytes > slot.capacity)
+        {
+            slot.capacity = bytes;
+            glBufferData(GL_PIXEL_PACK_BUFFER, bytes, NULL, GL_STREAM_READ);
+        }
+        // RGBA rows are always 4 byte aligned, the copy into the buffer returns right away
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(viewport[0], viewport[1], slot.width, slot.height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+        pending++;
+    }
+
+    bool FrameExporter::collect(bool wait)
+    {
+        if (pending == 0) return false;
+        Readback& slot = ring[oldest];
+        GLenum status;
+        do
+        {
+            // the flush makes sure the fence gets to the GPU at all
+            status = glClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? READBACK_WAIT_NS : 0);
+        } while (wait && status == GL_TIMEOUT_EXPIRED);
+        if (status == GL_TIMEOUT_EXPIRED) return false;
+        glDeleteSync(slot.fence);
+        slot.fence = 0;
+        oldest = (oldest + 1) % READBACK_RING_SIZE;
+        pending--;
+        if (status == GL_WAIT_FAILED)
+        {
+            std::cerr << "ERROR::EXPORT::WAIT_FAILED: " << slot.path << std::endl;
+            return true;
+        }
+        GLsizeiptr bytes = (GLsizeiptr)slot.width * slot.height * 4;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+        if (mapped == NULL)
+        {
+            std::cerr << "ERROR::EXPORT::MAP_FAILED: " << slot.path << std::endl;
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            return true;
+        }
+        EncodeJob job;
+        job.path = slot.path;
+        job.format = slot.format;
+        job.width = slot.width;
+        job.height = slot.height;
+        job.bottomUp = true;
+        job.pixels = encoder.take_buffer();
+        job.pixels.resize(bytes);
+        std::memcpy(job.pixels.data(), mapped, bytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        encoder.submit(std::move(job), slot.recorded);
+        return true;
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "frame_encoder.hpp"
+
+#include <string>
+
+namespace curves
+{
+    // pixel pack buffers in flight, a frame stays in one until its fence passed
+    const int READBACK_RING_SIZE = 3;
+
+    // Saves rendered frames without stalling the render loop. glReadPixels goes into a ring of
+    // pixel pack buffers, so it returns right away, and a fence marks when the copy is done.
+    // A buffer is mapped in a later frame once its fence passed (usually one or two frames on)
+    // and the pixels go to a FrameEncoder that writes them on its own thread.
+    class FrameExporter
+    {
+    public:
+        FrameExporter();
+        bool init();
+        // writes whatever is still in flight
+        void destroy();
+        // saves the frame that ends next
+        void capture(const std::string& path, ImageFormat format);
+        // saves every frame from the next one on as prefix00000.ext, prefix00001.ext, ...
+        // Frames the encoder has no room for are dropped, their numbers are left out.
+        void start_recording(const std::string& prefix, ImageFormat format);
+        void stop_recording();
+        bool is_recording() const;
+        // frames dropped since the last start_recording
+        size_t dropped_frames();
+        // call after drawing and before swapping, reads the frame if it's wanted and
+        // hands the reads that finished in the meantime to the encoder
+        void end_frame();
+        // waits for all reads and writes
+        void finish();
+    private:
+        struct Readback
+        {
+            GLuint buffer;
+            GLsizeiptr capacity;
+            GLsync fence;
+            int width, height;
+            std::string path;
+            ImageFormat format;
+            // part of a recording, which may lose a frame, unlike a capture
+            bool recorded;
+        };
+        void read_frame(const std::string& path, ImageFormat format, bool recorded);
+        // hands the oldest read to the encoder if its fence passed, or once it passes when waiting
+        bool collect(bool wait);
+        Readback ring[READBACK_RING_SIZE];
+        // ring[oldest] is the first of pending reads
+        int oldest, pending;
+        FrameEncoder encoder;
+        bool captureRequested;
+        std::string capturePath;
+        ImageFormat captureFormat;
+        bool recording;
+        std::string recordPrefix;
+        ImageFormat recordFormat;
+        int recordedFrames;
+        // encoder drops when the recording started
+        size_t droppedBefore;
+    };
+}
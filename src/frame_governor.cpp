@@ -0,0 +1,97 @@
+#include "frame_governor.hpp"
+
+#include <algorithm>
+
+namespace curves
+{
+    // weight of the newest frame in the average
+    const float FRAME_AVERAGE_WEIGHT = 0.1f;
+    // frames skipped after a level change
+    const int SETTLE_FRAMES = 10;
+    // frames over the budget before quality drops
+    const int DEGRADE_FRAMES = 8;
+    // the average has to be below this part of the budget to try the next better level
+    const float UPGRADE_HEADROOM = 0.6f;
+    // frames below the headroom before quality comes back, doubled after every failed try
+    const int UPGRADE_FRAMES = 30;
+    const int MAX_UPGRADE_FRAMES = 30 * 64;
+    // an upgrade that held this long worked, the wait goes back to UPGRADE_FRAMES
+    const int UPGRADE_PROVEN_FRAMES = 300;
+
+    FrameGovernor::FrameGovernor()
+    {
+        budget = 0.0f;
+        level = 0;
+        average = 0.0f;
+        settling = SETTLE_FRAMES;
+        framesOver = framesUnder = 0;
+        framesAtLevel = 0;
+        upgradeFrames = UPGRADE_FRAMES;
+        upgraded = false;
+    }
+
+    void FrameGovernor::set_budget(float milliseconds)
+    {
+        budget = std::max(milliseconds, 0.0f);
+        upgradeFrames = UPGRADE_FRAMES;
+        change_level(0);
+    }
+
+    float FrameGovernor::get_budget() const
+    {
+        return budget;
+    }
+
+    bool FrameGovernor::add_frame(float milliseconds)
+    {
+        if (budget <= 0.0f) return false;
+        framesAtLevel++;
+        if (upgraded && framesAtLevel >= UPGRADE_PROVEN_FRAMES)
+        {
+            upgraded = false;
+            upgradeFrames = UPGRADE_FRAMES;
+        }
+        if (settling > 0)
+        {
+            // the first frame that counts starts the average
+            if (--settling == 0) average = milliseconds;
+            return false;
+        }
+        average += FRAME_AVERAGE_WEIGHT * (milliseconds - average);
+        framesOver = average > budget ? framesOver + 1 : 0;
+        framesUnder = average < UPGRADE_HEADROOM * budget ? framesUnder + 1 : 0;
+        if (framesOver >= DEGRADE_FRAMES && level + 1 < QUALITY_LEVEL_COUNT)
+        {
+            // the better level didn't hold, wait longer before trying it again
+            if (upgraded) upgradeFrames = std::min(2 * upgradeFrames, MAX_UPGRADE_FRAMES);
+            change_level(level + 1);
+            upgraded = false;
+            return true;
+        }
+        if (framesUnder >= upgradeFrames && level > 0)
+        {
+            change_level(level - 1);
+            upgraded = true;
+            return true;
+        }
+        return false;
+    }
+
+    void FrameGovernor::change_level(int level)
+    {
+        this->level = level;
+        settling = SETTLE_FRAMES;
+        framesOver = framesUnder = 0;
+        framesAtLevel = 0;
+    }
+
+    int FrameGovernor::get_level() const
+    {
+        return level;
+    }
+
+    const QualityLevel& FrameGovernor::quality() const
+    {
+        return QUALITY_LEVELS[level];
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+namespace curves
+{
+    // one step of the quality ladder, FrameGovernor moves along QUALITY_LEVELS
+    struct QualityLevel
+    {
+        // multiplies the tessellation tolerance, fewer samples per curve
+        float toleranceScale;
+        // markers on every curve, or only on the one being edited
+        bool allMarkers;
+        // fraction of the window's width and height the curves are drawn at, for scenes that are
+        // slow to fill rather than slow to sample
+        float renderScale;
+    };
+
+    const int QUALITY_LEVEL_COUNT = 6;
+    // 0 is full quality, every step takes about a third off the sampled vertices
+    const QualityLevel QUALITY_LEVELS[QUALITY_LEVEL_COUNT] = {
+        { 1.0f, true, 1.0f },
+        { 2.0f, true, 1.0f },
+        { 4.0f, false, 0.75f },
+        { 8.0f, false, 0.75f },
+        { 16.0f, false, 0.5f },
+        { 32.0f, false, 0.5f }
+    };
+
+    // Keeps frames within a time budget by trading quality for speed. Frame times are averaged,
+    // a level is only given up after the average stayed over the budget for a few frames and
+    // only won back after it stayed well below it for longer. An upgrade that had to be taken back
+    // right away makes the next attempt wait twice as long, so a scene that sits between two
+    // levels doesn't flip between them.
+    class FrameGovernor
+    {
+    public:
+        FrameGovernor();
+        // in milliseconds, 0 turns the governor off and goes back to full quality
+        void set_budget(float milliseconds);
+        float get_budget() const;
+        // the work of the last frame in milliseconds, without waiting for vsync,
+        // returns whether the level changed
+        bool add_frame(float milliseconds);
+        int get_level() const;
+        const QualityLevel& quality() const;
+    private:
+        void change_level(int level);
+        float budget;
+        int level;
+        // average frame time since the level last changed
+        float average;
+        // frames still ignored after a change, the first ones pay for resampling everything
+        int settling;
+        int framesOver, framesUnder;
+        int framesAtLevel;
+        // frames below the budget an upgrade needs
+        int upgradeFrames;
+        // the last change was an upgrade
+        bool upgraded;
+    };
+}
@@ -0,0 +1,59 @@
+#include "gpu_timer.hpp"
+
+namespace curves
+{
+    GpuTimer::GpuTimer()
+    {
+        for (GLuint& query : queries)
+            query = 0;
+        oldest = pending = 0;
+        running = false;
+    }
+
+    void GpuTimer::init()
+    {
+        glGenQueries(GPU_TIMER_RING_SIZE, queries);
+    }
+
+    void GpuTimer::destroy()
+    {
+        glDeleteQueries(GPU_TIMER_RING_SIZE, queries);
+        for (GLuint& query : queries)
+            query = 0;
+        oldest = pending = 0;
+        running = false;
+    }
+
+    void GpuTimer::begin()
+    {
+        if (pending == GPU_TIMER_RING_SIZE) return;
+        glBeginQuery(GL_TIME_ELAPSED, queries[(oldest + pending) % GPU_TIMER_RING_SIZE]);
+        running = true;
+    }
+
+    void GpuTimer::end()
+    {
+        if (!running) return;
+        glEndQuery(GL_TIME_ELAPSED);
+        running = false;
+        pending++;
+    }
+
+    bool GpuTimer::read(float& milliseconds)
+    {
+        bool found = false;
+        while (pending > 0)
+        {
+            GLint available = 0;
+            glGetQueryObjectiv(queries[oldest], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) break;
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(queries[oldest], GL_QUERY_RESULT, &nanoseconds);
+            milliseconds = nanoseconds * 1e-6f;
+            found = true;
+            oldest = (oldest + 1) % GPU_TIMER_RING_SIZE;
+            pending--;
+        }
+        return found;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <glad/glad.h>
+
+namespace curves
+{
+    // queries in flight, results arrive a few frames late
+    const int GPU_TIMER_RING_SIZE = 4;
+
+    // Measures how long the GPU spends on the commands between begin and end with
+    // GL_TIME_ELAPSED queries, read back without waiting once they are done.
+    class GpuTimer
+    {
+    public:
+        GpuTimer();
+        void init();
+        void destroy();
+        // skips the frame if every query is still waiting for its result
+        void begin();
+        void end();
+        // the newest result that arrived since the last call, false if none did
+        bool read(float& milliseconds);
+    private:
+        GLuint queries[GPU_TIMER_RING_SIZE];
+        // queries[oldest] is the first of pending ones
+        int oldest, pending;
+        // begin started a query that end has to close
+        bool running;
+    };
+}
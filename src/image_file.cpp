@@ -0,0 +1,247 @@
+#include "image_file.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace curves
+{
+    namespace
+    {
+        // largest stored deflate block
+        const size_t STORED_BLOCK_BYTES = 65535;
+        // bytes the Adler-32 sums can take before they have to be reduced
+        const size_t ADLER_RUN_BYTES = 5552;
+
+        // slicing by 8: values[k][n] is the CRC of byte n followed by k zero bytes
+        struct CrcTable
+        {
+            uint32_t values[8][256];
+            CrcTable()
+            {
+                for (uint32_t n = 0; n < 256; n++)
+                {
+                    uint32_t c = n;
+                    for (int k = 0; k < 8; k++)
+                        c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    values[0][n] = c;
+                }
+                for (int k = 1; k < 8; k++)
+                    for (int n = 0; n < 256; n++)
+                        values[k][n] = values[0][values[k - 1][n] & 0xFF] ^ (values[k - 1][n] >> 8);
+            }
+        };
+
+        uint32_t crc32(uint32_t crc, const unsigned char* data, size_t size)
+        {
+            // built once, also when two threads get here first
+            static const CrcTable table;
+            const uint32_t (*t)[256] = table.values;
+            crc = ~crc;
+            // 8 bytes per step, assembled byte by byte so it works on any endianness
+            for (; size >= 8; size -= 8, data += 8)
+            {
+                uint32_t low = crc ^ (data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24);
+                crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24]
+                    ^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+            }
+            for (; size > 0; size--, data++)
+                crc = t[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+            return ~crc;
+        }
+
+        // Adler-32 that takes its input piece by piece
+        struct Adler32
+        {
+            uint32_t a, b;
+            // bytes added since the sums were last reduced
+            size_t run;
+            Adler32()
+            {
+                a = 1;
+                b = 0;
+                run = 0;
+            }
+            void add(const unsigned char* data, size_t size)
+            {
+                while (size > 0)
+                {
+                    size_t part = std::min(size, ADLER_RUN_BYTES - run);
+                    for (size_t i = 0; i < part; i++)
+                    {
+                        a += data[i];
+                        b += a;
+                    }
+                    data += part;
+                    size -= part;
+                    run += part;
+                    if (run < ADLER_RUN_BYTES) continue;
+                    a %= 65521;
+                    b %= 65521;
+                    run = 0;
+                }
+            }
+            uint32_t value() const
+            {
+                return (b % 65521) << 16 | (a % 65521);
+            }
+        };
+
+        void putBigEndian(std::vector<unsigned char>& out, uint32_t value)
+        {
+            out.push_back(value >> 24);
+            out.push_back(value >> 16);
+            out.push_back(value >> 8);
+            out.push_back(value);
+        }
+
+        // length, type, data and the CRC over type and data
+        void writeChunk(std::ofstream& out, const char* type, const std::vector<unsigned char>& data)
+        {
+            std::vector<unsigned char> chunk;
+            chunk.reserve(data.size() + 12);
+            putBigEndian(chunk, data.size());
+            chunk.insert(chunk.end(), type, type + 4);
+            chunk.insert(chunk.end(), data.begin(), data.end());
+            putBigEndian(chunk, crc32(0, &chunk[4], data.size() + 4));
+            out.write((const char*)chunk.data(), chunk.size());
+        }
+
+        // the row a file row comes from
+        const unsigned char* sourceRow(const unsigned char* rgba, int width, int height, int row, bool bottomUp)
+        {
+            return rgba + (size_t)(bottomUp ? height - 1 - row : row) * width * 4;
+        }
+
+        // Writes the data of an IDAT chunk, a zlib stream of stored blocks, straight to the file
+        // while it keeps the CRC of the chunk and the Adler-32 of the raw bytes.
+        class StoredBlockWriter
+        {
+        public:
+            StoredBlockWriter(std::ofstream& out, size_t rawBytes, uint32_t crc) : out(out)
+            {
+                remaining = rawBytes;
+                blockLeft = 0;
+                this->crc = crc;
+            }
+            void put(const unsigned char* data, size_t size)
+            {
+                while (size > 0)
+                {
+                    if (blockLeft == 0) begin_block();
+                    size_t part = std::min(size, blockLeft);
+                    write(data, part);
+                    adler.add(data, part);
+                    blockLeft -= part;
+                    remaining -= part;
+                    data += part;
+                    size -= part;
+                }
+            }
+            void write(const unsigned char* data, size_t size)
+            {
+                out.write((const char*)data, size);
+                crc = crc32(crc, data, size);
+            }
+            uint32_t get_crc() const
+            {
+                return crc;
+            }
+            uint32_t get_adler() const
+            {
+                return adler.value();
+            }
+        private:
+            void begin_block()
+            {
+                size_t size = std::min(STORED_BLOCK_BYTES, remaining);
+                unsigned char header[5] = { (unsigned char)(size == remaining ? 1 : 0), (unsigned char)(size & 0xFF),
+                    (unsigned char)(size >> 8), (unsigned char)(~size & 0xFF), (unsigned char)((~size >> 8) & 0xFF) };
+                write(header, 5);
+                blockLeft = size;
+            }
+            std::ofstream& out;
+            size_t remaining, blockLeft;
+            uint32_t crc;
+            Adler32 adler;
+        };
+
+        void writePng(std::ofstream& out, int width, int height, const unsigned char* rgba, bool bottomUp)
+        {
+            static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+            out.write((const char*)signature, 8);
+            std::vector<unsigned char> header;
+            putBigEndian(header, width);
+            putBigEndian(header, height);
+            // 8 bits, RGBA, deflate, adaptive filters, no interlacing
+            const unsigned char rest[5] = { 8, 6, 0, 0, 0 };
+            header.insert(header.end(), rest, rest + 5);
+            writeChunk(out, "IHDR", header);
+
+            // every row is filter type 0 and its bytes, they go out in stored blocks without being copied
+            size_t rawBytes = ((size_t)width * 4 + 1) * height;
+            size_t blocks = (rawBytes + STORED_BLOCK_BYTES - 1) / STORED_BLOCK_BYTES;
+            std::vector<unsigned char> start;
+            putBigEndian(start, 2 + 5 * blocks + rawBytes + 4);
+            const unsigned char type[4] = { 'I', 'D', 'A', 'T' };
+            start.insert(start.end(), type, type + 4);
+            out.write((const char*)start.data(), start.size());
+            // the CRC covers the chunk type too
+            StoredBlockWriter idat(out, rawBytes, crc32(0, type, 4));
+            const unsigned char zlibHeader[2] = { 0x78, 0x01 };
+            idat.write(zlibHeader, 2);
+            const unsigned char filter = 0;
+            for (int row = 0; row < height; row++)
+            {
+                idat.put(&filter, 1);
+                idat.put(sourceRow(rgba, width, height, row, bottomUp), (size_t)width * 4);
+            }
+            std::vector<unsigned char> end;
+            putBigEndian(end, idat.get_adler());
+            idat.write(end.data(), 4);
+            end.clear();
+            putBigEndian(end, idat.get_crc());
+            out.write((const char*)end.data(), 4);
+            writeChunk(out, "IEND", std::vector<unsigned char>());
+        }
+
+        void writePam(std::ofstream& out, int width, int height, const unsigned char* rgba, bool bottomUp)
+        {
+            out << "P7\nWIDTH " << width << "\nHEIGHT " << height << "\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n";
+            for (int row = 0; row < height; row++)
+                out.write((const char*)sourceRow(rgba, width, height, row, bottomUp), (size_t)width * 4);
+        }
+    }
+
+    const char* imageExtension(ImageFormat format)
+    {
+        return format == ImageFormat::Png ? ".png" : ".pam";
+    }
+
+    bool saveImage(const std::string& path, ImageFormat format, int width, int height, const unsigned char* rgba, bool bottomUp)
+    {
+        if (width <= 0 || height <= 0)
+        {
+            std::cerr << "ERROR::IMAGE::EMPTY: " << path << std::endl;
+            return false;
+        }
+        std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cerr << "ERROR::IMAGE::FILE_NOT_SUCCESFULLY_OPENED: " << path << std::endl;
+            return false;
+        }
+        if (format == ImageFormat::Png)
+            writePng(out, width, height, rgba, bottomUp);
+        else
+            writePam(out, width, height, rgba, bottomUp);
+        if (!out)
+        {
+            std::cerr << "ERROR::IMAGE::WRITE_FAILED: " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+namespace curves
+{
+    enum class ImageFormat
+    {
+        // 8-bit RGBA, stored without compression (there is no zlib to link against)
+        Png,
+        // the pixels as they are behind a Netpbm PAM header, for tools that turn sequences into videos
+        Raw
+    };
+
+    // file name extension of a format, with the dot
+    const char* imageExtension(ImageFormat format);
+
+    // writes width * height RGBA pixels, rows top to bottom, or bottom to top like glReadPixels gives them
+    bool saveImage(const std::string& path, ImageFormat format, int width, int height, const unsigned char* rgba, bool bottomUp);
+}
@@ -0,0 +1,119 @@
+#include "lagrange.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace curves
+{
+    // samples evaluated side by side, the inner Horner loop runs over them
+    const int SAMPLE_BLOCK = 64;
+    // high degree polynomials swing far out between the nodes, keep those vertices drawable
+    const double MAX_SAMPLE_COORD = 1e4;
+
+    namespace
+    {
+        double clampCoord(double v)
+        {
+            // NaN fails the comparison and ends up at the lower bound
+            return v > -MAX_SAMPLE_COORD ? std::min(v, MAX_SAMPLE_COORD) : -MAX_SAMPLE_COORD;
+        }
+    }
+
+    void NewtonPolynomial::clear()
+    {
+        coeffX.clear();
+        coeffY.clear();
+        rowX.clear();
+        rowY.clear();
+    }
+
+    void NewtonPolynomial::append(float x, float y)
+    {
+        int n = coeffX.size();
+        // the new row of the table: f[n], f[n - 1 .. n], ..., f[0 .. n]
+        double prevX = x, prevY = y;
+        for (int j = 0; j < n; j++)
+        {
+            // f[n - j - 1 .. n] = (f[n - j .. n] - f[n - j - 1 .. n - 1]) / (t_n - t_{n - j - 1})
+            double nextX = (prevX - rowX[j]) / (j + 1);
+            double nextY = (prevY - rowY[j]) / (j + 1);
+            rowX[j] = prevX;
+            rowY[j] = prevY;
+            prevX = nextX;
+            prevY = nextY;
+        }
+        rowX.push_back(prevX);
+        rowY.push_back(prevY);
+        coeffX.push_back(prevX);
+        coeffY.push_back(prevY);
+    }
+
+    void NewtonPolynomial::assign(const float* points, int count)
+    {
+        clear();
+        coeffX.reserve(count);
+        coeffY.reserve(count);
+        rowX.reserve(count);
+        rowY.reserve(count);
+        for (int i = 0; i < count; i++)
+            append(points[2 * i], points[2 * i + 1]);
+    }
+
+    int NewtonPolynomial::node_count() const
+    {
+        return coeffX.size();
+    }
+
+    void NewtonPolynomial::evaluate(double t, float& x, float& y) const
+    {
+        int n = coeffX.size();
+        if (n == 0)
+        {
+            x = y = 0.0f;
+            return;
+        }
+        // Horner, innermost factor first
+        double vx = coeffX[n - 1], vy = coeffY[n - 1];
+        for (int k = n - 2; k >= 0; k--)
+        {
+            vx = coeffX[k] + (t - k) * vx;
+            vy = coeffY[k] + (t - k) * vy;
+        }
+        x = (float)clampCoord(vx);
+        y = (float)clampCoord(vy);
+    }
+
+    void NewtonPolynomial::sample(int numPoints, float* out) const
+    {
+        int n = coeffX.size();
+        if (n == 0) return;
+        double span = n - 1;
+        double t[SAMPLE_BLOCK], vx[SAMPLE_BLOCK], vy[SAMPLE_BLOCK];
+        for (int first = 0; first <= numPoints; first += SAMPLE_BLOCK)
+        {
+            int count = std::min(SAMPLE_BLOCK, numPoints + 1 - first);
+            for (int i = 0; i < count; i++)
+            {
+                t[i] = numPoints > 0 ? span * (first + i) / numPoints : 0.0;
+                vx[i] = coeffX[n - 1];
+                vy[i] = coeffY[n - 1];
+            }
+            // Horner with the samples in the inner loop, which the compiler can vectorize
+            for (int k = n - 2; k >= 0; k--)
+            {
+                double ax = coeffX[k], ay = coeffY[k];
+                for (int i = 0; i < count; i++)
+                {
+                    double factor = t[i] - k;
+                    vx[i] = ax + factor * vx[i];
+                    vy[i] = ay + factor * vy[i];
+                }
+            }
+            for (int i = 0; i < count; i++)
+            {
+                out[2 * (first + i)] = (float)clampCoord(vx[i]);
+                out[2 * (first + i) + 1] = (float)clampCoord(vy[i]);
+            }
+        }
+    }
+}
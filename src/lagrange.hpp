@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+
+namespace curves
+{
+    // Interpolating polynomial through 2D nodes at t = 0, 1, 2, ... kept in Newton form:
+    // p(t) = a0 + (t - 0)(a1 + (t - 1)(a2 + ...)), a_k being the divided differences f[0..k].
+    // Appending a node only adds one divided difference column, O(n).
+    class NewtonPolynomial
+    {
+    public:
+        void clear();
+        // O(n)
+        void append(float x, float y);
+        // rebuilds from count nodes, O(n^2)
+        void assign(const float* points, int count);
+        int node_count() const;
+        void evaluate(double t, float& x, float& y) const;
+        // numPoints + 1 vertices (2 floats each) over the whole node range [0 : n - 1]
+        void sample(int numPoints, float* out) const;
+    private:
+        std::vector<double> coeffX, coeffY;
+        // last row of the divided difference table: row[j] = f[n - 1 - j .. n - 1]
+        std::vector<double> rowX, rowY;
+    };
+}
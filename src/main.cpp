@@ -1,9 +1,15 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include "camera.hpp"
 #include "curves.hpp"
 #include "curve_program.hpp"
+#include "curve_renderer.hpp"
+#include "frame_exporter.hpp"
+#include "frame_governor.hpp"
+#include "gpu_timer.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -13,8 +19,33 @@
 // --- Configuration ---
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
+// time a frame may take before the governor lowers the quality
+const float FRAME_BUDGET_MS = 8.0f;
 
 curves::CurveProgram program;
+// upload 16-bit vertices instead of floats, toggled with Q
+bool compactVertices = false;
+// cubics sampled evenly along their length, toggled with E
+bool evenSpacing = false;
+// hairlines, wide anti-aliased strokes or cubics shaded per pixel, cycled with W
+curves::LineMode lineMode = curves::LineMode::Hairline;
+// print what every frame sent to the GPU, toggled with U
+bool showUploads = false;
+// keep the curves that aren't edited in a texture, toggled with K
+bool layerCache = true;
+// P saves the window as capture_N.png, R records every frame as frame_NNNNN.png (Shift+R as raw frames)
+curves::FrameExporter exporter;
+int captureCount = 0;
+// Ctrl+S saves the drawing as scene_N.oglc
+int sceneCount = 0;
+// keeps frames within FRAME_BUDGET_MS, toggled with G
+curves::FrameGovernor governor;
+// raw motion is on, it only arrives while the cursor is disabled, so it is disabled during drags
+bool rawMotion = false;
+// buttons held that drag a point or the view
+int dragButtons = 0;
+// the most the curves are drawn at (the governor may go lower), cycled with S
+float renderScaleSetting = 1.0f;
 
 // --- Shader Loading Utility ---
 GLuint loadShaders(const char* vertexPath, const char* fragmentPath)
@@ -102,35 +133,30 @@ GLuint loadShaders(const char* vertexPath, const char* fragmentPath)
     return ID;
 }
 
-// --- Simple Orthographic Projection ---
-// Creates a matrix to map coordinates from world space (-w/2 to w/2, -h/2 to h/2)
-// to clip space (-1 to 1)
-void createOrthoProjection(float* matrix, float left, float right, float bottom, float top, float nearVal, float farVal)
-{
-    matrix[0] = 2.0f / (right - left);
-    matrix[4] = 0.0f;
-    matrix[8] = 0.0f;
-    matrix[12] = -(right + left) / (right - left);
-    matrix[1] = 0.0f;
-    matrix[5] = 2.0f / (top - bottom);
-    matrix[9] = 0.0f;
-    matrix[13] = -(top + bottom) / (top - bottom);
-    matrix[2] = 0.0f;
-    matrix[6] = 0.0f;
-    matrix[10] = -2.0f / (farVal - nearVal);
-    matrix[14] = -(farVal + nearVal) / (farVal - nearVal);
-    matrix[3] = 0.0f;
-    matrix[7] = 0.0f;
-    matrix[11] = 0.0f;
-    matrix[15] = 1.0f;
-}
-
 // Callback function for window resize
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     glViewport(0, 0, width, height);
 }
 
+void beginCursorDrag(GLFWwindow* window)
+{
+    if (rawMotion && dragButtons++ == 0)
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+}
+
+void endCursorDrag(GLFWwindow* window)
+{
+    if (!rawMotion || dragButtons == 0 || --dragButtons > 0) return;
+    // GLFW puts the cursor back where the drag started, it belongs where the drag ended
+    double x, y;
+    glfwGetCursorPos(window, &x, &y);
+    int width, height;
+    glfwGetWindowSize(window, &width, &height);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+    glfwSetCursorPos(window, std::min(std::max(x, 0.0), (double)width), std::min(std::max(y, 0.0), (double)height));
+}
+
 // Responsible for mouse clicks
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 {
@@ -139,15 +165,150 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
         if (action == GLFW_PRESS)
         {
             program.press_mouse();
+            beginCursorDrag(window);
         }
         else if (action == GLFW_RELEASE)
         {
             program.release_mouse();
+            endCursorDrag(window);
+        }
+    }
+    else if (button == GLFW_MOUSE_BUTTON_RIGHT || button == GLFW_MOUSE_BUTTON_MIDDLE)
+    {
+        if (action == GLFW_PRESS)
+        {
+            program.press_pan();
+            beginCursorDrag(window);
+        }
+        else if (action == GLFW_RELEASE)
+        {
+            program.release_pan();
+            endCursorDrag(window);
         }
     }
 }
 
-int main()
+// Zooms around the cursor
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    program.scroll(yoffset);
+}
+
+// Cursor movement is queued in the program and applied once per frame
+void cursor_pos_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    program.cursor_moved(xpos, ypos, glfwGetTime());
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (key == GLFW_KEY_Q && action == GLFW_PRESS)
+    {
+        compactVertices = !compactVertices;
+        std::cout << (compactVertices ? "16-bit vertices" : "float vertices") << std::endl;
+    }
+    else if (key == GLFW_KEY_Z && (mods & GLFW_MOD_CONTROL) && action != GLFW_RELEASE)
+    {
+        // Ctrl+Shift+Z redoes like Ctrl+Y
+        if (mods & GLFW_MOD_SHIFT)
+            program.redo();
+        else
+            program.undo();
+    }
+    else if (key == GLFW_KEY_Y && (mods & GLFW_MOD_CONTROL) && action != GLFW_RELEASE)
+    {
+        program.redo();
+    }
+    else if (key == GLFW_KEY_E && action == GLFW_PRESS)
+    {
+        evenSpacing = !evenSpacing;
+        std::cout << (evenSpacing ? "arc length sampling" : "uniform t sampling") << std::endl;
+    }
+    else if (key == GLFW_KEY_L && action == GLFW_PRESS)
+    {
+        // the following clicks place its nodes
+        program.new_curve(curves::CurveType::Lagrange);
+    }
+    else if (key == GLFW_KEY_C && action == GLFW_PRESS)
+    {
+        // Shift picks the centripetal variant
+        program.new_curve((mods & GLFW_MOD_SHIFT) ? curves::CurveType::Centripetal : curves::CurveType::CatmullRom);
+    }
+    else if (key == GLFW_KEY_T && action == GLFW_PRESS)
+    {
+        program.new_curve(curves::CurveType::Cardinal);
+    }
+    else if (key == GLFW_KEY_U && action == GLFW_PRESS)
+    {
+        showUploads = !showUploads;
+    }
+    else if (key == GLFW_KEY_K && action == GLFW_PRESS)
+    {
+        layerCache = !layerCache;
+        std::cout << (layerCache ? "cached static layer" : "everything redrawn every frame") << std::endl;
+    }
+    else if (key == GLFW_KEY_P && action == GLFW_PRESS)
+    {
+        std::string path = "capture_" + std::to_string(captureCount++) + ".png";
+        exporter.capture(path, curves::ImageFormat::Png);
+        std::cout << "saving " << path << std::endl;
+    }
+    else if (key == GLFW_KEY_R && action == GLFW_PRESS)
+    {
+        if (exporter.is_recording())
+        {
+            exporter.stop_recording();
+            std::cout << "recording stopped, " << exporter.dropped_frames() << " frames dropped" << std::endl;
+        }
+        else
+        {
+            exporter.start_recording("frame_", (mods & GLFW_MOD_SHIFT) ? curves::ImageFormat::Raw : curves::ImageFormat::Png);
+            std::cout << "recording" << std::endl;
+        }
+    }
+    else if (key == GLFW_KEY_G && action == GLFW_PRESS)
+    {
+        governor.set_budget(governor.get_budget() > 0.0f ? 0.0f : FRAME_BUDGET_MS);
+        std::cout << (governor.get_budget() > 0.0f ? "frame budget on" : "full quality") << std::endl;
+    }
+    else if (key == GLFW_KEY_S && (mods & GLFW_MOD_CONTROL) && action == GLFW_PRESS)
+    {
+        std::string path = "scene_" + std::to_string(sceneCount++) + ".oglc";
+        if (program.save_scene(path))
+            std::cout << "saved " << path << std::endl;
+    }
+    else if (key == GLFW_KEY_S && action == GLFW_PRESS)
+    {
+        renderScaleSetting = renderScaleSetting > 0.75f ? 0.75f : renderScaleSetting > 0.5f ? 0.5f : 1.0f;
+        std::cout << "render scale " << renderScaleSetting << std::endl;
+    }
+    else if (key == GLFW_KEY_W && action == GLFW_PRESS)
+    {
+        switch (lineMode)
+        {
+        case curves::LineMode::Hairline:
+            lineMode = curves::LineMode::Stroke;
+            std::cout << "wide strokes" << std::endl;
+            break;
+        case curves::LineMode::Stroke:
+            lineMode = curves::LineMode::Hull;
+            std::cout << "per pixel cubics" << std::endl;
+            break;
+        case curves::LineMode::Hull:
+            lineMode = curves::LineMode::Hairline;
+            std::cout << "hairlines" << std::endl;
+            break;
+        }
+    }
+}
+
+// Cursor positions are in screen coordinates, so track the window size (not the framebuffer size)
+void window_size_callback(GLFWwindow* window, int width, int height)
+{
+    program.resize_window(width, height);
+}
+
+int main(int argc, char** argv)
 {
     // --- Initialize GLFW ---
     if (!glfwInit())
@@ -183,101 +344,117 @@ int main()
 
     // --- Load Shaders ---
     GLuint shaderProgram = loadShaders("shaders/line.vert", "shaders/line.frag");
-    if (shaderProgram == 0)
+    GLuint strokeProgram = loadShaders("shaders/stroke.vert", "shaders/stroke.frag");
+    GLuint hullProgram = loadShaders("shaders/hull.vert", "shaders/hull.frag");
+    GLuint compositeProgram = loadShaders("shaders/composite.vert", "shaders/composite.frag");
+    if (shaderProgram == 0 || strokeProgram == 0 || hullProgram == 0 || compositeProgram == 0)
     {
         glfwTerminate();
         return -1;
     }
-    
-    program = curves::CurveProgram();
-
-    glfwSetMouseButtonCallback(window, mouse_button_callback);
-
-    // --- Setup Buffers (VAO, VBO) (This part is purely generated with ChatGPT) ---
-    GLuint VAO, VBO;
-    glGenVertexArrays(1, &VAO); // Create Vertex Array Object
-    glGenBuffers(1, &VBO);      // Create Vertex Buffer Object
-
-    glBindVertexArray(VAO); // Bind VAO
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO); // Bind VBO to the GL_ARRAY_BUFFER target
-    // Copy the point data into the VBO
-    glBufferData(GL_ARRAY_BUFFER, program.get_line_coords().size() * sizeof(float), program.get_line_coords().data(), GL_STATIC_DRAW);
 
-    // Configure vertex attributes (tell OpenGL how to interpret the VBO data)
-    // layout (location = 0) in vec2 aPos; -> location 0
-    // vec2 -> size 2
-    // float -> type GL_FLOAT
-    // Normalize? -> GL_FALSE
-    // Stride (bytes between vertices) -> 2 * sizeof(float)
-    // Offset (bytes from start) -> 0
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0); // Enable the vertex attribute (location 0)
+    // optional scene file to open instead of the default curve
+    if (argc > 1 && !program.load_scene(argv[1]))
+    {
+        glfwTerminate();
+        return -1;
+    }
 
-    // Unbind VBO and VAO (good practice, prevents accidental modification)
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetCursorPosCallback(window, cursor_pos_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetWindowSizeCallback(window, window_size_callback);
+    glfwSetKeyCallback(window, key_callback);
+    // Unaccelerated motion for tablets and mice. GLFW only delivers it while the cursor is disabled,
+    // which it is while a button drags something.
+    rawMotion = glfwRawMouseMotionSupported() == GLFW_TRUE;
+    if (rawMotion)
+        glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
+    int windowWidth, windowHeight;
+    glfwGetWindowSize(window, &windowWidth, &windowHeight);
+    program.resize_window(windowWidth, windowHeight);
+
+    curves::CurveRenderer renderer;
+    if (!renderer.init(shaderProgram, strokeProgram, hullProgram, compositeProgram))
+    {
+        glfwTerminate();
+        return -1;
+    }
+    exporter.init();
+    curves::GpuTimer gpuTimer;
+    gpuTimer.init();
+    governor.set_budget(FRAME_BUDGET_MS);
+    // GPU time of the newest frame whose query came back
+    float gpuMilliseconds = 0.0f;
 
     // --- Projection Matrix (also ChatGPT) ---
-    // Use orthographic projection for 2D. Map world coordinates (e.g., -1 to 1)
-    // to OpenGL's normalized device coordinates (-1 to 1).
+    // Use orthographic projection for 2D. The camera maps the visible part of the world
+    // to OpenGL's normalized device coordinates (-1 to 1), it's rebuilt every frame.
     float projection[16];
-    // Simple projection matching common clip space for now
-    createOrthoProjection(projection, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
-    // If you want coordinates to map directly to pixels (0,0 top-left):
-    // createOrthoProjection(projection, 0.0f, (float)SCR_WIDTH, (float)SCR_HEIGHT, 0.0f, -1.0f, 1.0f);
-    // Adjust your 'points' vector accordingly if you change the projection.
 
     // --- Render Loop ---
     while (!glfwWindowShouldClose(window))
     {
         // --- Input ---
+        // Poll right before the drag is applied so the newest cursor position makes it into this frame
+        glfwPollEvents();
+        // the frame's work is measured from here to the swap, waiting for vsync doesn't count
+        double frameStart = glfwGetTime();
+        gpuTimer.begin();
+        program.begin_frame();
         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
             glfwSetWindowShouldClose(window, true);
         
-        program.update_drag(window);
+        program.update_drag(glfwGetTime());
 
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f); // Set background color
         glClear(GL_COLOR_BUFFER_BIT);         // Clear framebuffer
 
-        // Use the shader program
-        glUseProgram(shaderProgram);
-
-        // Set the projection uniform in the vertex shader
-        GLint projLoc = glGetUniformLocation(shaderProgram, "projection");
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, projection);
-
-        // Bind the VAO (which contains the VBO configuration)
-        glBindVertexArray(VAO);
-
         // Update the points for the line and crosses
+        program.set_cubic_hulls(lineMode == curves::LineMode::Hull);
+        program.set_even_spacing(evenSpacing);
+        program.set_quality(governor.quality());
         program.refresh_line();
         // TODO check if I really need this
         glfwSetMouseButtonCallback(window, mouse_button_callback);
 
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, program.get_line_coords().size() * sizeof(float), program.get_line_coords().data());
-
-        // Number of vertices to draw
-        int numVertices = program.get_line_coords().size() / 2;
-        // Draw the lines!
-        // GL_LINE_STRIP connects vertices in a line
-        glDrawArrays(GL_LINE_STRIP, 0, numVertices - 64);
-        // GL_LINES draws the crosses (like cross-strokes)
-        glDrawArrays(GL_LINES, numVertices - 64, 64);
-
-        // Unbind VAO
-        glBindVertexArray(0);
-
-        // --- Swap Buffers and Poll Events ---
+        renderer.set_compact(compactVertices);
+        renderer.set_line_mode(lineMode);
+        renderer.set_layer_cache(layerCache);
+        renderer.set_render_scale(std::min(renderScaleSetting, governor.quality().renderScale));
+        renderer.set_live_curve(program.live_curve(), program.layer_revision());
+        renderer.upload(program.get_line_coords(), program.get_draw_list(), program.get_camera().pixel_size());
+        renderer.upload_hulls(program.get_hull_controls(), program.get_hull_curves());
+        const curves::UploadStats& uploads = renderer.get_frame_stats();
+        // quiet frames stay quiet
+        if (showUploads && (uploads.bytes > 0 || uploads.copiedBytes > 0))
+            std::cout << uploads.bytes << " bytes in " << uploads.ranges << " uploads, "
+                << uploads.copiedBytes << " bytes moved" << std::endl;
+
+        // The camera maps the visible part of the world to the screen
+        program.get_camera().projection(projection);
+        renderer.draw(projection);
+        exporter.end_frame();
+        gpuTimer.end();
+
+        // whichever side is slower sets the pace
+        gpuTimer.read(gpuMilliseconds);
+        float cpuMilliseconds = (float)((glfwGetTime() - frameStart) * 1000.0);
+        if (governor.add_frame(std::max(cpuMilliseconds, gpuMilliseconds)))
+            std::cout << "quality level " << governor.get_level() << std::endl;
+
+        // --- Swap Buffers ---
         glfwSwapBuffers(window); // Show the rendered frame
-        glfwPollEvents();        // Check for input events (keyboard, mouse, window close)
     }
 
     // --- 9. Cleanup ---
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    exporter.destroy();
+    gpuTimer.destroy();
+    renderer.destroy();
     glDeleteProgram(shaderProgram);
+    glDeleteProgram(strokeProgram);
+    glDeleteProgram(hullProgram);
+    glDeleteProgram(compositeProgram);
 
     glfwTerminate(); // Clean up GLFW resources
     return 0;
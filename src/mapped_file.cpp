@@ -0,0 +1,107 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace curves
+{
+    MappedFile::MappedFile()
+    {
+        base = NULL;
+        length = 0;
+#ifdef _WIN32
+        fileHandle = INVALID_HANDLE_VALUE;
+        mappingHandle = NULL;
+#endif
+    }
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    bool MappedFile::open(const std::string& path)
+    {
+        close();
+#ifdef _WIN32
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (fileHandle == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+        {
+            close();
+            return false;
+        }
+        length = (size_t)fileSize.QuadPart;
+        mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        if (mappingHandle == NULL)
+        {
+            close();
+            return false;
+        }
+        base = (unsigned char*)MapViewOfFile(mappingHandle, FILE_MAP_COPY, 0, 0, 0);
+        if (base == NULL)
+        {
+            close();
+            return false;
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        length = (size_t)info.st_size;
+        void* mapped = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        // the mapping keeps its own reference to the file
+        ::close(fd);
+        if (mapped == MAP_FAILED)
+        {
+            length = 0;
+            return false;
+        }
+        base = (unsigned char*)mapped;
+#endif
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+#ifdef _WIN32
+        if (base != NULL) UnmapViewOfFile(base);
+        if (mappingHandle != NULL) CloseHandle(mappingHandle);
+        if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+        mappingHandle = NULL;
+        fileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (base != NULL) munmap(base, length);
+#endif
+        base = NULL;
+        length = 0;
+    }
+
+    bool MappedFile::is_open() const
+    {
+        return base != NULL;
+    }
+
+    unsigned char* MappedFile::data() const
+    {
+        return base;
+    }
+
+    size_t MappedFile::size() const
+    {
+        return length;
+    }
+}
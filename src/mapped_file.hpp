@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace curves
+{
+    // Read-only file mapped copy-on-write: pages are loaded lazily on first access,
+    // and writes go to private pages without ever reaching the file.
+    class MappedFile
+    {
+    public:
+        MappedFile();
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        bool open(const std::string& path);
+        void close();
+        bool is_open() const;
+        unsigned char* data() const;
+        size_t size() const;
+    private:
+        unsigned char* base;
+        size_t length;
+#ifdef _WIN32
+        void* fileHandle;
+        void* mappingHandle;
+#endif
+    };
+}
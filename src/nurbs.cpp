@@ -0,0 +1,309 @@
+#include "nurbs.hpp"
+#include "curves.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace curves
+{
+    // samples of a span evaluated side by side, the inner loops run over them
+    const int SPAN_BLOCK = 64;
+
+    namespace
+    {
+        // Cox-de Boor for a block of samples inside span [knots[i] : knots[i + 1]], then the weighted
+        // control points i - p .. i are summed up
+        void sampleBlock(int p, const float* knots, int i, const float* weighted, const float* u, int count, float* out)
+        {
+            // basis[k][s] is N(i - p + k) at sample s
+            float basis[MAX_NURBS_DEGREE + 1][SPAN_BLOCK];
+            float left[MAX_NURBS_DEGREE + 1][SPAN_BLOCK];
+            float right[MAX_NURBS_DEGREE + 1][SPAN_BLOCK];
+            float saved[SPAN_BLOCK];
+            for (int s = 0; s < count; s++)
+                basis[0][s] = 1.0f;
+            for (int j = 1; j <= p; j++)
+            {
+                for (int s = 0; s < count; s++)
+                {
+                    left[j][s] = u[s] - knots[i + 1 - j];
+                    right[j][s] = knots[i + j] - u[s];
+                    saved[s] = 0.0f;
+                }
+                for (int r = 0; r < j; r++)
+                {
+                    // right[r + 1] + left[j - r] doesn't depend on u, it's non-zero inside a non-empty span
+                    float inverse = 1.0f / (knots[i + r + 1] - knots[i + 1 + r - j]);
+                    for (int s = 0; s < count; s++)
+                    {
+                        float temp = basis[r][s] * inverse;
+                        basis[r][s] = saved[s] + right[r + 1][s] * temp;
+                        saved[s] = left[j - r][s] * temp;
+                    }
+                }
+                for (int s = 0; s < count; s++)
+                    basis[j][s] = saved[s];
+            }
+            float x[SPAN_BLOCK], y[SPAN_BLOCK], w[SPAN_BLOCK];
+            std::fill(x, x + count, 0.0f);
+            std::fill(y, y + count, 0.0f);
+            std::fill(w, w + count, 0.0f);
+            const float* controls = &weighted[3 * (i - p)];
+            for (int k = 0; k <= p; k++)
+            {
+                float cx = controls[3 * k], cy = controls[3 * k + 1], cw = controls[3 * k + 2];
+                for (int s = 0; s < count; s++)
+                {
+                    x[s] += basis[k][s] * cx;
+                    y[s] += basis[k][s] * cy;
+                    w[s] += basis[k][s] * cw;
+                }
+            }
+            for (int s = 0; s < count; s++)
+            {
+                out[2 * s] = x[s] / w[s];
+                out[2 * s + 1] = y[s] / w[s];
+            }
+        }
+
+        // blossom of the weighted polynomial piece on span i: de Boor's algorithm with a different
+        // parameter on every level, all of them u gives the point at u
+        void blossom(int p, const float* knots, int i, const float* weighted, const float* args, float* out)
+        {
+            float d[MAX_NURBS_DEGREE + 1][3];
+            for (int j = 0; j <= p; j++)
+                std::copy(&weighted[3 * (i - p + j)], &weighted[3 * (i - p + j)] + 3, d[j]);
+            for (int r = 1; r <= p; r++)
+            {
+                for (int j = p; j >= r; j--)
+                {
+                    float alpha = (args[r - 1] - knots[i - p + j]) / (knots[i + 1 + j - r] - knots[i - p + j]);
+                    for (int k = 0; k < 3; k++)
+                        d[j][k] = (1.0f - alpha) * d[j - 1][k] + alpha * d[j][k];
+                }
+            }
+            std::copy(d[p], d[p] + 3, out);
+        }
+    }
+
+    bool checkNurbs(const NurbsData& nurbs, size_t pointCount)
+    {
+        int p = nurbs.degree;
+        if (p < 1 || p > MAX_NURBS_DEGREE)
+        {
+            std::cerr << "ERROR::NURBS::UNSUPPORTED_DEGREE: " << p << std::endl;
+            return false;
+        }
+        if (pointCount < (size_t)p + 1 || nurbs.knots.size() != pointCount + p + 1 || nurbs.weights.size() != pointCount)
+        {
+            std::cerr << "ERROR::NURBS::TABLE_SIZE_MISMATCH: " << pointCount << " points, " << nurbs.knots.size()
+                << " knots, " << nurbs.weights.size() << " weights" << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < nurbs.knots.size(); i++)
+        {
+            if (!std::isfinite(nurbs.knots[i]) || (i > 0 && nurbs.knots[i] < nurbs.knots[i - 1]))
+            {
+                std::cerr << "ERROR::NURBS::KNOTS_NOT_ASCENDING: knot " << i << std::endl;
+                return false;
+            }
+        }
+        if (!(nurbs.knots[p] < nurbs.knots[pointCount]))
+        {
+            std::cerr << "ERROR::NURBS::EMPTY_DOMAIN" << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < pointCount; i++)
+        {
+            // negative weights would move the curve out of the hull of its control points
+            if (!(nurbs.weights[i] > 0.0f) || !std::isfinite(nurbs.weights[i]))
+            {
+                std::cerr << "ERROR::NURBS::WEIGHT_NOT_POSITIVE: weight " << i << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    NurbsEvaluator::NurbsEvaluator()
+    {
+        degree = 0;
+        lastSpan = 0;
+    }
+
+    void NurbsEvaluator::assign(const NurbsData& nurbs, const float* points, int pointCount)
+    {
+        degree = nurbs.degree;
+        knots = nurbs.knots;
+        weighted.resize(3 * pointCount);
+        for (int i = 0; i < pointCount; i++)
+        {
+            float w = nurbs.weights[i];
+            weighted[3 * i] = w * points[2 * i];
+            weighted[3 * i + 1] = w * points[2 * i + 1];
+            weighted[3 * i + 2] = w;
+        }
+        spans.clear();
+        for (int i = degree; i < pointCount; i++)
+            if (knots[i] < knots[i + 1]) spans.push_back(i);
+        lastSpan = 0;
+        cubics.clear();
+        if (degree > 3) return;
+        cubics.resize(12 * spans.size());
+        for (int span = 0; span < (int)spans.size(); span++)
+            extract_cubic(span);
+    }
+
+    void NurbsEvaluator::move_point(int point, float x, float y)
+    {
+        float w = weighted[3 * point + 2];
+        weighted[3 * point] = w * x;
+        weighted[3 * point + 1] = w * y;
+        if (cubics.empty()) return;
+        // the point belongs to the spans with knot index point .. point + degree
+        std::vector<int>::iterator first = std::lower_bound(spans.begin(), spans.end(), point);
+        std::vector<int>::iterator last = std::upper_bound(spans.begin(), spans.end(), point + degree);
+        for (std::vector<int>::iterator span = first; span != last; ++span)
+            extract_cubic(span - spans.begin());
+    }
+
+    void NurbsEvaluator::extract_cubic(int span)
+    {
+        // Bezier point k of a span is the blossom with degree - k times its start and k times its end
+        int i = spans[span];
+        float bezier[4][3];
+        for (int k = 0; k <= degree; k++)
+        {
+            float args[3];
+            for (int j = 0; j < degree; j++)
+                args[j] = j < degree - k ? knots[i] : knots[i + 1];
+            blossom(degree, knots.data(), i, weighted.data(), args, bezier[k]);
+        }
+        // lower degrees are raised to cubics
+        float* c = &cubics[12 * span];
+        for (int k = 0; k < 3; k++)
+        {
+            float b0 = bezier[0][k], b1 = bezier[1][k];
+            float b2 = degree >= 2 ? bezier[2][k] : 0.0f;
+            float b3 = degree == 3 ? bezier[3][k] : 0.0f;
+            c[k] = b0;
+            if (degree == 1)
+            {
+                c[3 + k] = (2 * b0 + b1) / 3;
+                c[6 + k] = (b0 + 2 * b1) / 3;
+                c[9 + k] = b1;
+            }
+            else if (degree == 2)
+            {
+                c[3 + k] = (b0 + 2 * b1) / 3;
+                c[6 + k] = (2 * b1 + b2) / 3;
+                c[9 + k] = b2;
+            }
+            else
+            {
+                c[3 + k] = b1;
+                c[6 + k] = b2;
+                c[9 + k] = b3;
+            }
+        }
+    }
+
+    int NurbsEvaluator::span_count() const
+    {
+        return spans.size();
+    }
+
+    int NurbsEvaluator::span_first_point(int span) const
+    {
+        return spans[span] - degree;
+    }
+
+    int NurbsEvaluator::span_sample_count(int span, float pixelsPerUnit, float tolerance) const
+    {
+        if (!cubics.empty())
+        {
+            // Wang's formula on the projected Bezier points
+            const float* c = &cubics[12 * span];
+            float projected[8];
+            for (int k = 0; k < 4; k++)
+            {
+                projected[2 * k] = c[3 * k] / c[3 * k + 2];
+                projected[2 * k + 1] = c[3 * k + 1] / c[3 * k + 2];
+            }
+            return cubicSampleCount(projected, pixelsPerUnit, tolerance);
+        }
+        // largest second difference of the span's control polygon
+        const float* c = &weighted[3 * span_first_point(span)];
+        float m = 0.0f;
+        for (int k = 0; k + 2 <= degree; k++)
+        {
+            float dx = c[3 * k] / c[3 * k + 2] - 2 * c[3 * k + 3] / c[3 * k + 5] + c[3 * k + 6] / c[3 * k + 8];
+            float dy = c[3 * k + 1] / c[3 * k + 2] - 2 * c[3 * k + 4] / c[3 * k + 5] + c[3 * k + 7] / c[3 * k + 8];
+            m = std::max(m, dx * dx + dy * dy);
+        }
+        m = std::sqrt(m) * pixelsPerUnit;
+        int n = (int)std::ceil(std::sqrt(degree * (degree - 1) / 8.0f * m / tolerance));
+        return std::min(std::max(n, 1), MAX_CURVE_SAMPLES);
+    }
+
+    int NurbsEvaluator::find_span(float u) const
+    {
+        int count = spans.size();
+        // consecutive samples stay in their span or move on to the next one
+        for (int k = lastSpan; k < lastSpan + 2 && k < count; k++)
+        {
+            if (u >= knots[spans[k]] && u < knots[spans[k] + 1])
+            {
+                lastSpan = k;
+                return k;
+            }
+        }
+        // the first span whose end lies past u, the domain's end belongs to the last span
+        int first = 0, last = count - 1;
+        while (first < last)
+        {
+            int mid = (first + last) / 2;
+            if (knots[spans[mid] + 1] > u) last = mid;
+            else first = mid + 1;
+        }
+        lastSpan = first;
+        return first;
+    }
+
+    void NurbsEvaluator::evaluate(float u, float& x, float& y) const
+    {
+        if (spans.empty())
+        {
+            x = y = 0.0f;
+            return;
+        }
+        u = std::min(std::max(u, knots[spans.front()]), knots[spans.back() + 1]);
+        int i = spans[find_span(u)];
+        float args[MAX_NURBS_DEGREE];
+        std::fill(args, args + degree, u);
+        float point[3];
+        blossom(degree, knots.data(), i, weighted.data(), args, point);
+        x = point[0] / point[2];
+        y = point[1] / point[2];
+    }
+
+    void NurbsEvaluator::sample_span(int span, int samples, float* out) const
+    {
+        if (!cubics.empty())
+        {
+            genRationalCubicCurve(samples, &cubics[12 * span], out);
+            return;
+        }
+        int i = spans[span];
+        float u0 = knots[i], u1 = knots[i + 1];
+        float u[SPAN_BLOCK];
+        for (int first = 0; first <= samples; first += SPAN_BLOCK)
+        {
+            int count = std::min(SPAN_BLOCK, samples + 1 - first);
+            for (int s = 0; s < count; s++)
+                u[s] = u0 + (u1 - u0) * (float)(first + s) / (float)samples;
+            sampleBlock(degree, knots.data(), i, weighted.data(), u, count, &out[2 * first]);
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace curves
+{
+    // highest degree the evaluator takes
+    const int MAX_NURBS_DEGREE = 9;
+
+    // Degree, knots and weights of a rational B-spline, its control points live in the scene.
+    // There are pointCount + degree + 1 non-decreasing knots and one positive weight per control point.
+    struct NurbsData
+    {
+        int degree;
+        std::vector<float> knots;
+        std::vector<float> weights;
+    };
+
+    // prints what is wrong and returns false if the data can't belong to a curve of pointCount points
+    bool checkNurbs(const NurbsData& nurbs, size_t pointCount);
+
+    // Evaluates one NURBS curve. The control points are kept weighted (w x, w y, w), a point that
+    // moved has to be passed to move_point. Spans of degree 3 and less
+    // are turned into rational cubic Bezier pieces there and sampled with the same cached basis
+    // as the cubics, higher degrees run Cox-de Boor over blocks of samples.
+    class NurbsEvaluator
+    {
+    public:
+        NurbsEvaluator();
+        // O(n)
+        void assign(const NurbsData& nurbs, const float* points, int pointCount);
+        // only redoes the degree + 1 spans the point belongs to
+        void move_point(int point, float x, float y);
+        // spans with a non-empty parameter interval
+        int span_count() const;
+        // span s depends on the degree + 1 control points starting at this one
+        int span_first_point(int span) const;
+        // samples a span needs to stay within tolerance pixels of the curve, Wang's formula on its
+        // (projected) control polygon, so how the weights speed up or slow down the curve is ignored
+        int span_sample_count(int span, float pixelsPerUnit, float tolerance) const;
+        // point at parameter u (clamped to the domain) by de Boor's algorithm, the span of the previous
+        // call is tried first so walking along the curve doesn't search the knots
+        void evaluate(float u, float& x, float& y) const;
+        // samples + 1 vertices of span s evenly in its parameter interval to out
+        void sample_span(int span, int samples, float* out) const;
+    private:
+        int find_span(float u) const;
+        void extract_cubic(int span);
+        int degree;
+        std::vector<float> knots;
+        // w x, w y, w per control point
+        std::vector<float> weighted;
+        // knot index i of every non-empty span [knots[i] : knots[i + 1]]
+        std::vector<int> spans;
+        // 4 weighted Bezier points per span, empty above degree 3
+        std::vector<float> cubics;
+        // index into spans of the last evaluate
+        mutable int lastSpan;
+    };
+}
@@ -0,0 +1,254 @@
+#include "point_grid.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace curves
+{
+    // cell size for points that don't span an area, in world units
+    const float DEFAULT_CELL_SIZE = 0.1f;
+    // coarse levels are added until the points fit into this many top level cells per side
+    const int TOP_LEVEL_CELLS = 8;
+    const int MAX_LEVELS = 12;
+
+    PointGrid::PointGrid()
+    {
+        cellSize = DEFAULT_CELL_SIZE;
+        minCellX = minCellY = INT_MAX;
+        maxCellX = maxCellY = INT_MIN;
+    }
+
+    void PointGrid::build(const float* points, int count)
+    {
+        cells.clear();
+        levels.clear();
+        minCellX = minCellY = INT_MAX;
+        maxCellX = maxCellY = INT_MIN;
+        if (count == 0) return;
+        // bounding box of all points
+        float minX = points[0], maxX = points[0], minY = points[1], maxY = points[1];
+        for (int i = 1; i < count; i++)
+        {
+            minX = std::min(minX, points[2 * i]);
+            maxX = std::max(maxX, points[2 * i]);
+            minY = std::min(minY, points[2 * i + 1]);
+            maxY = std::max(maxY, points[2 * i + 1]);
+        }
+        // aim for about two points per cell if they were spread evenly
+        float area = (maxX - minX) * (maxY - minY);
+        float length = std::max(maxX - minX, maxY - minY);
+        if (area > 0.0f)
+            cellSize = std::sqrt(area * 2.0f / count);
+        else if (length > 0.0f)
+            // all on one horizontal or vertical line
+            cellSize = length * 2.0f / count;
+        else
+            cellSize = DEFAULT_CELL_SIZE;
+        cellSize = std::max(cellSize, 1e-5f);
+        int cellsX = cell_coord(maxX) - cell_coord(minX) + 1;
+        int cellsY = cell_coord(maxY) - cell_coord(minY) + 1;
+        int levelCount = 0;
+        while (levelCount < MAX_LEVELS && (std::max(cellsX, cellsY) >> (2 * levelCount)) > TOP_LEVEL_CELLS)
+            levelCount++;
+        levels.resize(levelCount);
+        cells.reserve(count);
+        for (int i = 0; i < count; i++)
+            insert(i, points[2 * i], points[2 * i + 1]);
+    }
+
+    void PointGrid::insert(int index, float x, float y)
+    {
+        Entry entry = { x, y, index };
+        int cx = cell_coord(x);
+        int cy = cell_coord(y);
+        cells[cell_key(cx, cy)].push_back(entry);
+        count(cx, cy, 1);
+        minCellX = std::min(minCellX, cx);
+        minCellY = std::min(minCellY, cy);
+        maxCellX = std::max(maxCellX, cx);
+        maxCellY = std::max(maxCellY, cy);
+    }
+
+    void PointGrid::move(int index, float oldX, float oldY, float newX, float newY)
+    {
+        int oldCX = cell_coord(oldX), oldCY = cell_coord(oldY);
+        uint64_t oldKey = cell_key(oldCX, oldCY);
+        uint64_t newKey = cell_key(cell_coord(newX), cell_coord(newY));
+        std::unordered_map<uint64_t, std::vector<Entry>>::iterator cell = cells.find(oldKey);
+        if (cell != cells.end())
+        {
+            std::vector<Entry>& entries = cell->second;
+            for (size_t i = 0; i < entries.size(); i++)
+            {
+                if (entries[i].index != index) continue;
+                if (oldKey == newKey)
+                {
+                    entries[i].x = newX;
+                    entries[i].y = newY;
+                    return;
+                }
+                // order inside a cell doesn't matter
+                entries[i] = entries.back();
+                entries.pop_back();
+                count(oldCX, oldCY, -1);
+                break;
+            }
+            if (entries.empty()) cells.erase(cell);
+        }
+        insert(index, newX, newY);
+    }
+
+    void PointGrid::count(int cx, int cy, int delta)
+    {
+        for (size_t level = 1; level <= levels.size(); level++)
+        {
+            uint64_t key = cell_key(coarse_coord(cx, level), coarse_coord(cy, level));
+            int& points = levels[level - 1][key];
+            points += delta;
+            if (points == 0) levels[level - 1].erase(key);
+        }
+    }
+
+    int PointGrid::nearest(float x, float y, float radius) const
+    {
+        if (cells.empty()) return -1;
+        float best = radius * radius;
+        int bestIndex = -1;
+        // start on the finest level whose cells are as large as the radius, the search box
+        // there is at most 3 x 3 cells
+        int top = levels.size();
+        int level = 0;
+        while (level < top && std::ldexp(cellSize, 2 * level) < radius)
+            level++;
+        // cells that overlap both the search box and the occupied box
+        float size = std::ldexp(cellSize, 2 * level);
+        float minX = coarse_coord(minCellX, level), maxX = coarse_coord(maxCellX, level);
+        float minY = coarse_coord(minCellY, level), maxY = coarse_coord(maxCellY, level);
+        int fromX = (int)std::max(std::floor((x - radius) / size), minX);
+        int toX = (int)std::min(std::floor((x + radius) / size), maxX);
+        int fromY = (int)std::max(std::floor((y - radius) / size), minY);
+        int toY = (int)std::min(std::floor((y + radius) / size), maxY);
+        if (fromX > toX || fromY > toY) return -1;
+        topCells.clear();
+        size_t occupied = level > 0 ? levels[level - 1].size() : cells.size();
+        if ((int64_t)(toX - fromX + 1) * (toY - fromY + 1) > (int64_t)occupied)
+        {
+            // a radius beyond the top level, or the occupied box grew far out because a point was
+            // dragged away, list the occupied cells instead
+            if (level > 0)
+            {
+                for (std::unordered_map<uint64_t, int>::const_iterator cell = levels[level - 1].begin(); cell != levels[level - 1].end(); ++cell)
+                {
+                    Candidate candidate = { 0.0f, (int)(uint32_t)(cell->first >> 32), (int)(uint32_t)cell->first };
+                    topCells.push_back(candidate);
+                }
+            }
+            else
+            {
+                for (std::unordered_map<uint64_t, std::vector<Entry>>::const_iterator cell = cells.begin(); cell != cells.end(); ++cell)
+                {
+                    Candidate candidate = { 0.0f, (int)(uint32_t)(cell->first >> 32), (int)(uint32_t)cell->first };
+                    topCells.push_back(candidate);
+                }
+            }
+        }
+        else
+        {
+            // emptiness is found out by search, only if the cell is still in reach by then
+            for (int gy = fromY; gy <= toY; gy++)
+            {
+                for (int gx = fromX; gx <= toX; gx++)
+                {
+                    Candidate candidate = { 0.0f, gx, gy };
+                    topCells.push_back(candidate);
+                }
+            }
+        }
+        for (Candidate& candidate : topCells)
+            candidate.distance = cell_distance(candidate.cx, candidate.cy, level, x, y);
+        // closest cells first, so the radius shrinks quickly
+        std::sort(topCells.begin(), topCells.end());
+        for (const Candidate& candidate : topCells)
+        {
+            if (candidate.distance > best) break;
+            search(level, candidate.cx, candidate.cy, x, y, best, bestIndex);
+        }
+        return bestIndex;
+    }
+
+    void PointGrid::search(int level, int cx, int cy, float x, float y, float& best, int& bestIndex) const
+    {
+        if (level == 0)
+        {
+            std::unordered_map<uint64_t, std::vector<Entry>>::const_iterator cell = cells.find(cell_key(cx, cy));
+            if (cell != cells.end()) nearest_in(cell->second, x, y, best, bestIndex);
+            return;
+        }
+        if (levels[level - 1].count(cell_key(cx, cy)) == 0) return;
+        // the subcells in reach, sorted by distance
+        Candidate children[16];
+        int childCount = 0;
+        for (int j = 0; j < 4; j++)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                int gx = cx * 4 + i, gy = cy * 4 + j;
+                float distance = cell_distance(gx, gy, level - 1, x, y);
+                if (distance > best) continue;
+                int k = childCount++;
+                for (; k > 0 && children[k - 1].distance > distance; k--)
+                    children[k] = children[k - 1];
+                Candidate child = { distance, gx, gy };
+                children[k] = child;
+            }
+        }
+        for (int k = 0; k < childCount; k++)
+        {
+            if (children[k].distance > best) break;
+            search(level - 1, children[k].cx, children[k].cy, x, y, best, bestIndex);
+        }
+    }
+
+    void PointGrid::nearest_in(const std::vector<Entry>& entries, float x, float y, float& best, int& bestIndex)
+    {
+        for (const Entry& entry : entries)
+        {
+            float dx = entry.x - x;
+            float dy = entry.y - y;
+            float distance = dx * dx + dy * dy;
+            if (distance <= best)
+            {
+                best = distance;
+                bestIndex = entry.index;
+            }
+        }
+    }
+
+    float PointGrid::cell_distance(int cx, int cy, int level, float x, float y) const
+    {
+        float size = std::ldexp(cellSize, 2 * level);
+        // a little larger than the cell, cell_coord rounds points on the border either way
+        float slack = size * (1.0f / 1024.0f);
+        float dx = std::max(std::max(cx * size - slack - x, x - (cx + 1) * size - slack), 0.0f);
+        float dy = std::max(std::max(cy * size - slack - y, y - (cy + 1) * size - slack), 0.0f);
+        return dx * dx + dy * dy;
+    }
+
+    int PointGrid::cell_coord(float v) const
+    {
+        return (int)std::floor(v / cellSize);
+    }
+
+    int PointGrid::coarse_coord(int c, int level)
+    {
+        // rounds down for negative cells too
+        int shift = 2 * level;
+        return c >= 0 ? c >> shift : -((-(c + 1)) >> shift) - 1;
+    }
+
+    uint64_t PointGrid::cell_key(int cx, int cy)
+    {
+        return ((uint64_t)(uint32_t)cx << 32) | (uint32_t)cy;
+    }
+}
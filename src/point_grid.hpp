@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace curves
+{
+    // Uniform hash grid over the control points (flat x, y pairs) for picking.
+    // Points are referenced by their index, so the grid has to be told about every move.
+    // Above the grid sit coarser levels that only count points, each cell covering 4 x 4 cells
+    // of the level below, so a search skips empty space in big steps however large the pick radius is.
+    class PointGrid
+    {
+    public:
+        PointGrid();
+        // rebuilds the grid and picks a cell size that keeps a few points per cell
+        void build(const float* points, int pointCount);
+        void insert(int index, float x, float y);
+        void move(int index, float oldX, float oldY, float newX, float newY);
+        // index of the closest point within radius, or -1 if there is none
+        int nearest(float x, float y, float radius) const;
+    private:
+        // positions are kept next to the index so a lookup never touches the point array
+        struct Entry
+        {
+            float x, y;
+            int index;
+        };
+        // a cell of some level and its smallest possible distance to the search point, squared
+        struct Candidate
+        {
+            float distance;
+            int cx, cy;
+            bool operator<(const Candidate& other) const { return distance < other.distance; }
+        };
+        int cell_coord(float v) const;
+        static uint64_t cell_key(int cx, int cy);
+        // the cell of level (0 is the grid) that covers cell c of the grid
+        static int coarse_coord(int c, int level);
+        float cell_distance(int cx, int cy, int level, float x, float y) const;
+        // adds delta to the cells covering grid cell (cx, cy) on every coarse level
+        void count(int cx, int cy, int delta);
+        // closest point in cell (cx, cy) of level, if it has any
+        void search(int level, int cx, int cy, float x, float y, float& best, int& bestIndex) const;
+        static void nearest_in(const std::vector<Entry>& entries, float x, float y, float& best, int& bestIndex);
+        float cellSize;
+        // every occupied grid cell lies in this box, it only grows until the next build
+        int minCellX, minCellY, maxCellX, maxCellY;
+        std::unordered_map<uint64_t, std::vector<Entry>> cells;
+        // points per cell of level 1, 2, ...
+        std::vector<std::unordered_map<uint64_t, int>> levels;
+        // cells a search starts from, kept to not allocate per click
+        mutable std::vector<Candidate> topCells;
+    };
+}
@@ -0,0 +1,67 @@
+#include "scaled_target.hpp"
+
+#include <iostream>
+
+namespace curves
+{
+    ScaledTarget::ScaledTarget()
+    {
+        framebuffer = color = 0;
+        width = height = 0;
+        previousFramebuffer = 0;
+    }
+
+    void ScaledTarget::init()
+    {
+        glGenFramebuffers(1, &framebuffer);
+        glGenRenderbuffers(1, &color);
+    }
+
+    void ScaledTarget::destroy()
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(1, &color);
+        framebuffer = color = 0;
+        width = height = 0;
+    }
+
+    bool ScaledTarget::begin(int width, int height)
+    {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+        if (width != this->width || height != this->height)
+        {
+            // it's only ever blitted from, so a renderbuffer does
+            glBindRenderbuffer(GL_RENDERBUFFER, color);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+            glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+            this->width = width;
+            this->height = height;
+            if (glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            {
+                std::cerr << "ERROR::SCALED_TARGET::INCOMPLETE_FRAMEBUFFER" << std::endl;
+                this->width = this->height = 0;
+                glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousFramebuffer);
+                return false;
+            }
+        }
+        glClear(GL_COLOR_BUFFER_BIT);
+        return true;
+    }
+
+    void ScaledTarget::end()
+    {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousFramebuffer);
+    }
+
+    void ScaledTarget::present(const GLint* viewport)
+    {
+        GLint readFramebuffer;
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        glBlitFramebuffer(0, 0, width, height, viewport[0], viewport[1], viewport[0] + viewport[2], viewport[1] + viewport[3],
+            GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <glad/glad.h>
+
+namespace curves
+{
+    // An offscreen color buffer smaller than the window. The scene is drawn into it and then
+    // stretched over the window with a linear filtered blit, so fewer pixels have to be filled.
+    class ScaledTarget
+    {
+    public:
+        ScaledTarget();
+        void init();
+        void destroy();
+        // redirects drawing into a width x height buffer, cleared with the current clear color,
+        // returns false (and draws nowhere else) if the framebuffer can't be made
+        bool begin(int width, int height);
+        // back to the framebuffer that was bound before begin
+        void end();
+        // stretches the buffer over the viewport (x, y, width, height) of that framebuffer
+        void present(const GLint* viewport);
+    private:
+        GLuint framebuffer, color;
+        int width, height;
+        GLint previousFramebuffer;
+    };
+}
@@ -0,0 +1,204 @@
+#include "scene.hpp"
+
+#include <algorithm>
+
+namespace curves
+{
+    PointArray::PointArray()
+    {
+        base = NULL;
+        count = 0;
+    }
+
+    PointArray::PointArray(std::shared_ptr<MappedFile> mapping, float* data, size_t count)
+        : mapping(mapping), base(data), count(count)
+    {
+    }
+
+    PointArray::PointArray(const PointArray& other)
+        : owned(other.owned), mapping(other.mapping), count(other.count)
+    {
+        base = mapping ? other.base : owned.data();
+    }
+
+    PointArray& PointArray::operator=(const PointArray& other)
+    {
+        if (this == &other) return *this;
+        owned = other.owned;
+        mapping = other.mapping;
+        count = other.count;
+        base = mapping ? other.base : owned.data();
+        return *this;
+    }
+
+    size_t PointArray::size() const
+    {
+        return count;
+    }
+
+    float* PointArray::data()
+    {
+        return base;
+    }
+
+    const float* PointArray::data() const
+    {
+        return base;
+    }
+
+    float& PointArray::operator[](size_t i)
+    {
+        return base[i];
+    }
+
+    const float& PointArray::operator[](size_t i) const
+    {
+        return base[i];
+    }
+
+    void PointArray::assign(const float* first, const float* last)
+    {
+        mapping.reset();
+        owned.assign(first, last);
+        base = owned.data();
+        count = owned.size();
+    }
+
+    void PointArray::insert(size_t at, const float* first, const float* last)
+    {
+        detach();
+        owned.insert(owned.begin() + at, first, last);
+        base = owned.data();
+        count = owned.size();
+    }
+
+    void PointArray::erase(size_t at, size_t count)
+    {
+        detach();
+        owned.erase(owned.begin() + at, owned.begin() + at + count);
+        base = owned.data();
+        this->count = owned.size();
+    }
+
+    bool PointArray::is_mapped() const
+    {
+        return mapping != NULL;
+    }
+
+    void PointArray::detach()
+    {
+        if (!mapping) return;
+        owned.assign(base, base + count);
+        mapping.reset();
+        base = owned.data();
+    }
+
+    Scene::Scene()
+    {
+        offsets.push_back(0);
+    }
+
+    void Scene::clear()
+    {
+        types.clear();
+        offsets.assign(1, 0);
+        nurbs.clear();
+        controlPoints = PointArray();
+    }
+
+    int Scene::curve_count() const
+    {
+        return types.size();
+    }
+
+    CurveType Scene::curve_type(int curve) const
+    {
+        return types[curve];
+    }
+
+    size_t Scene::curve_first(int curve) const
+    {
+        return offsets[curve];
+    }
+
+    size_t Scene::curve_point_count(int curve) const
+    {
+        return offsets[curve + 1] - offsets[curve];
+    }
+
+    int Scene::curve_of_point(size_t point) const
+    {
+        // last curve starting at or before the point
+        return std::upper_bound(offsets.begin(), offsets.end(), (uint64_t)point) - offsets.begin() - 1;
+    }
+
+    size_t Scene::point_count() const
+    {
+        return controlPoints.size() / 2;
+    }
+
+    PointArray& Scene::points()
+    {
+        return controlPoints;
+    }
+
+    const PointArray& Scene::points() const
+    {
+        return controlPoints;
+    }
+
+    void Scene::add_curve(CurveType type, const float* points, size_t pointCount)
+    {
+        controlPoints.insert(controlPoints.size(), points, points + 2 * pointCount);
+        types.push_back(type);
+        offsets.push_back(offsets.back() + pointCount);
+        nurbs.push_back(NurbsData());
+        nurbs.back().degree = 0;
+    }
+
+    bool Scene::add_nurbs_curve(const float* points, size_t pointCount, const NurbsData& data)
+    {
+        if (!checkNurbs(data, pointCount)) return false;
+        add_curve(CurveType::Nurbs, points, pointCount);
+        nurbs.back() = data;
+        return true;
+    }
+
+    const NurbsData& Scene::curve_nurbs(int curve) const
+    {
+        return nurbs[curve];
+    }
+
+    void Scene::insert_points(int curve, size_t at, const float* points, size_t pointCount)
+    {
+        controlPoints.insert(2 * at, points, points + 2 * pointCount);
+        for (size_t i = curve + 1; i < offsets.size(); i++)
+            offsets[i] += pointCount;
+    }
+
+    void Scene::erase_points(int curve, size_t at, size_t pointCount)
+    {
+        controlPoints.erase(2 * at, 2 * pointCount);
+        for (size_t i = curve + 1; i < offsets.size(); i++)
+            offsets[i] -= pointCount;
+    }
+
+    void Scene::assign(const std::vector<CurveType>& types, const std::vector<uint64_t>& offsets, const PointArray& points,
+        const std::vector<NurbsData>& nurbs)
+    {
+        this->types = types;
+        this->offsets = offsets;
+        this->nurbs = nurbs;
+        controlPoints = points;
+    }
+
+    const std::vector<CurveType>& Scene::get_types() const
+    {
+        return types;
+    }
+
+    const std::vector<uint64_t>& Scene::get_offsets() const
+    {
+        return offsets;
+    }
+}
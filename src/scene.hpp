@@ -0,0 +1,80 @@
+#pragma once
+
+#include "curves.hpp"
+#include "mapped_file.hpp"
+#include "nurbs.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace curves
+{
+    // Flat x, y control point storage. It either owns its floats or uses a mapped
+    // scene file in place; in-place writes stay private to the process, and anything
+    // that changes the size copies the mapped floats into owned storage first.
+    // Copies of a mapped array share the mapped floats.
+    class PointArray
+    {
+    public:
+        PointArray();
+        // no copy, the array keeps the mapping alive
+        PointArray(std::shared_ptr<MappedFile> mapping, float* data, size_t count);
+        PointArray(const PointArray& other);
+        PointArray& operator=(const PointArray& other);
+        size_t size() const;
+        float* data();
+        const float* data() const;
+        float& operator[](size_t i);
+        const float& operator[](size_t i) const;
+        void assign(const float* first, const float* last);
+        void insert(size_t at, const float* first, const float* last);
+        void erase(size_t at, size_t count);
+        bool is_mapped() const;
+    private:
+        void detach();
+        std::vector<float> owned;
+        std::shared_ptr<MappedFile> mapping;
+        float* base;
+        size_t count;
+    };
+
+    // All curves of a drawing. Their control points are stored back to back,
+    // curve i owns the points [offsets[i] : offsets[i + 1]).
+    class Scene
+    {
+    public:
+        Scene();
+        void clear();
+        int curve_count() const;
+        CurveType curve_type(int curve) const;
+        // index of the first point of a curve (in points, not floats)
+        size_t curve_first(int curve) const;
+        size_t curve_point_count(int curve) const;
+        int curve_of_point(size_t point) const;
+        size_t point_count() const;
+        PointArray& points();
+        const PointArray& points() const;
+        // Nurbs curves need their knots and weights, they are added with add_nurbs_curve
+        void add_curve(CurveType type, const float* points, size_t pointCount);
+        // leaves the scene as it is and returns false if the data doesn't fit the points
+        bool add_nurbs_curve(const float* points, size_t pointCount, const NurbsData& nurbs);
+        // knots and weights of a Nurbs curve, degree 0 and empty for the other types
+        const NurbsData& curve_nurbs(int curve) const;
+        // inserts pointCount points in front of point index at, which belongs to curve
+        void insert_points(int curve, size_t at, const float* points, size_t pointCount);
+        // removes pointCount points starting at point index at, all of them from curve
+        void erase_points(int curve, size_t at, size_t pointCount);
+        // takes over the tables of a loaded scene, the points are used as they are
+        void assign(const std::vector<CurveType>& types, const std::vector<uint64_t>& offsets, const PointArray& points,
+            const std::vector<NurbsData>& nurbs);
+        const std::vector<CurveType>& get_types() const;
+        const std::vector<uint64_t>& get_offsets() const;
+    private:
+        std::vector<CurveType> types;
+        std::vector<uint64_t> offsets;
+        // one entry per curve
+        std::vector<NurbsData> nurbs;
+        PointArray controlPoints;
+    };
+}
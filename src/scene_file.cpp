@@ -0,0 +1,206 @@
+#include "scene_file.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace curves
+{
+    static_assert(sizeof(SceneHeader) == 48, "SceneHeader must match the file layout");
+
+    namespace
+    {
+        bool hostIsLittleEndian()
+        {
+            uint32_t probe = 1;
+            unsigned char first;
+            std::memcpy(&first, &probe, 1);
+            return first == 1;
+        }
+
+        uint64_t alignUp(uint64_t offset)
+        {
+            return (offset + SCENE_ALIGNMENT - 1) / SCENE_ALIGNMENT * SCENE_ALIGNMENT;
+        }
+
+        void writePadding(std::ofstream& out, uint64_t from, uint64_t to)
+        {
+            static const char zeros[SCENE_ALIGNMENT] = {};
+            out.write(zeros, to - from);
+        }
+    }
+
+    bool loadScene(const std::string& path, Scene& scene)
+    {
+        // the points are used in place, so the file has to be in the host byte order
+        if (!hostIsLittleEndian())
+        {
+            std::cerr << "ERROR::SCENE::BIG_ENDIAN_HOST_NOT_SUPPORTED" << std::endl;
+            return false;
+        }
+        std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+        if (!file->open(path))
+        {
+            std::cerr << "ERROR::SCENE::FILE_NOT_SUCCESFULLY_MAPPED: " << path << std::endl;
+            return false;
+        }
+        const unsigned char* data = file->data();
+        uint64_t size = file->size();
+        SceneHeader header;
+        if (size < sizeof(header))
+        {
+            std::cerr << "ERROR::SCENE::TRUNCATED_HEADER: " << path << std::endl;
+            return false;
+        }
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, SCENE_MAGIC, 4) != 0)
+        {
+            std::cerr << "ERROR::SCENE::NOT_A_SCENE_FILE: " << path << std::endl;
+            return false;
+        }
+        if (header.version != 1 && header.version != SCENE_VERSION)
+        {
+            std::cerr << "ERROR::SCENE::UNSUPPORTED_VERSION: " << header.version << std::endl;
+            return false;
+        }
+        uint64_t curveCount = header.curveCount;
+        bool fits = header.typesOffset <= size && curveCount * 4 <= size - header.typesOffset
+            && header.offsetsOffset <= size && (curveCount + 1) * 8 <= size - header.offsetsOffset
+            && header.pointsOffset <= size && header.pointCount <= (size - header.pointsOffset) / 8
+            && header.pointsOffset % sizeof(float) == 0;
+        if (!fits)
+        {
+            std::cerr << "ERROR::SCENE::SECTIONS_OUT_OF_BOUNDS: " << path << std::endl;
+            return false;
+        }
+
+        // the tables are small next to the points, they get copied and checked
+        std::vector<CurveType> types(curveCount);
+        for (uint64_t i = 0; i < curveCount; i++)
+        {
+            uint32_t code;
+            std::memcpy(&code, data + header.typesOffset + 4 * i, 4);
+            switch (code)
+            {
+            case (uint32_t)CurveType::CubicBezier:
+            case (uint32_t)CurveType::Lagrange:
+            case (uint32_t)CurveType::CatmullRom:
+            case (uint32_t)CurveType::Centripetal:
+            case (uint32_t)CurveType::Cardinal:
+            case (uint32_t)CurveType::Nurbs:
+                types[i] = (CurveType)code;
+                break;
+            default:
+                std::cerr << "ERROR::SCENE::UNKNOWN_CURVE_TYPE: " << code << std::endl;
+                return false;
+            }
+        }
+        std::vector<uint64_t> offsets(curveCount + 1);
+        std::memcpy(offsets.data(), data + header.offsetsOffset, 8 * (curveCount + 1));
+        bool ordered = offsets[0] == 0 && offsets[curveCount] == header.pointCount;
+        for (uint64_t i = 0; ordered && i < curveCount; i++)
+            ordered = offsets[i] <= offsets[i + 1];
+        if (!ordered)
+        {
+            std::cerr << "ERROR::SCENE::INVALID_OFFSET_TABLE: " << path << std::endl;
+            return false;
+        }
+
+        // knots and weights are copied, they are small next to the points of the other curves
+        std::vector<NurbsData> nurbs(curveCount);
+        uint64_t at = alignUp(header.pointsOffset + 8 * header.pointCount);
+        for (uint64_t i = 0; i < curveCount; i++)
+        {
+            nurbs[i].degree = 0;
+            if (types[i] != CurveType::Nurbs) continue;
+            uint64_t pointCount = offsets[i + 1] - offsets[i];
+            uint32_t degree = 0;
+            if (header.version >= 2 && at <= size && size - at >= 4)
+                std::memcpy(&degree, data + at, 4);
+            uint64_t knotCount = pointCount + degree + 1;
+            if (header.version < 2 || degree > (uint32_t)MAX_NURBS_DEGREE || at > size || (size - at) / 4 < 1 + knotCount + pointCount)
+            {
+                std::cerr << "ERROR::SCENE::TRUNCATED_NURBS_SECTION: curve " << i << std::endl;
+                return false;
+            }
+            nurbs[i].degree = degree;
+            nurbs[i].knots.resize(knotCount);
+            nurbs[i].weights.resize(pointCount);
+            std::memcpy(nurbs[i].knots.data(), data + at + 4, 4 * knotCount);
+            std::memcpy(nurbs[i].weights.data(), data + at + 4 + 4 * knotCount, 4 * pointCount);
+            at += 4 * (1 + knotCount + pointCount);
+            if (!checkNurbs(nurbs[i], pointCount)) return false;
+        }
+
+        float* points = (float*)(file->data() + header.pointsOffset);
+        scene.assign(types, offsets, PointArray(file, points, 2 * header.pointCount), nurbs);
+        return true;
+    }
+
+    bool saveScene(const std::string& path, const Scene& scene)
+    {
+        if (!hostIsLittleEndian())
+        {
+            std::cerr << "ERROR::SCENE::BIG_ENDIAN_HOST_NOT_SUPPORTED" << std::endl;
+            return false;
+        }
+        // truncating path in place would pull the points out from under a mapping of it
+        std::string temporary = path + ".tmp";
+        std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cerr << "ERROR::SCENE::FILE_NOT_SUCCESFULLY_OPENED: " << temporary << std::endl;
+            return false;
+        }
+        uint64_t curveCount = scene.curve_count();
+        SceneHeader header;
+        std::memcpy(header.magic, SCENE_MAGIC, 4);
+        header.version = SCENE_VERSION;
+        header.curveCount = (uint32_t)curveCount;
+        header.reserved = 0;
+        header.pointCount = scene.point_count();
+        header.typesOffset = alignUp(sizeof(header));
+        header.offsetsOffset = alignUp(header.typesOffset + 4 * curveCount);
+        header.pointsOffset = alignUp(header.offsetsOffset + 8 * (curveCount + 1));
+
+        out.write((const char*)&header, sizeof(header));
+        writePadding(out, sizeof(header), header.typesOffset);
+        for (CurveType type : scene.get_types())
+        {
+            uint32_t code = (uint32_t)type;
+            out.write((const char*)&code, 4);
+        }
+        writePadding(out, header.typesOffset + 4 * curveCount, header.offsetsOffset);
+        out.write((const char*)scene.get_offsets().data(), 8 * (curveCount + 1));
+        writePadding(out, header.offsetsOffset + 8 * (curveCount + 1), header.pointsOffset);
+        out.write((const char*)scene.points().data(), scene.points().size() * sizeof(float));
+        uint64_t nurbsOffset = alignUp(header.pointsOffset + 8 * header.pointCount);
+        writePadding(out, header.pointsOffset + 8 * header.pointCount, nurbsOffset);
+        for (int curve = 0; curve < scene.curve_count(); curve++)
+        {
+            if (scene.curve_type(curve) != CurveType::Nurbs) continue;
+            const NurbsData& nurbs = scene.curve_nurbs(curve);
+            uint32_t degree = nurbs.degree;
+            out.write((const char*)&degree, 4);
+            out.write((const char*)nurbs.knots.data(), 4 * nurbs.knots.size());
+            out.write((const char*)nurbs.weights.data(), 4 * nurbs.weights.size());
+        }
+        out.close();
+        if (!out)
+        {
+            std::cerr << "ERROR::SCENE::WRITE_FAILED: " << temporary << std::endl;
+            std::remove(temporary.c_str());
+            return false;
+        }
+        // rename doesn't replace an existing file everywhere
+        if (std::rename(temporary.c_str(), path.c_str()) != 0
+            && (std::remove(path.c_str()) != 0 || std::rename(temporary.c_str(), path.c_str()) != 0))
+        {
+            std::cerr << "ERROR::SCENE::FILE_NOT_REPLACED: " << path << std::endl;
+            std::remove(temporary.c_str());
+            return false;
+        }
+        return true;
+    }
+}
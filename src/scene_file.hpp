@@ -0,0 +1,40 @@
+#pragma once
+
+#include "scene.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace curves
+{
+    // Binary scene layout, all little-endian:
+    //   SceneHeader
+    //   uint32 curve type table    [curveCount]   (CurveType values)
+    //   uint64 point offset table  [curveCount + 1], first point of each curve plus the total
+    //   float32 control points     [2 * pointCount], x, y pairs
+    //   NURBS data (version 2), for every Nurbs curve in order of the curves:
+    //     uint32 degree, float32 knots [pointCount + degree + 1], float32 weights [pointCount]
+    // Every section starts at a multiple of SCENE_ALIGNMENT so the points can be used in place.
+    // Version 1 files are still read, they have no NURBS section.
+    const char SCENE_MAGIC[4] = { 'O', 'G', 'L', 'C' };
+    const uint32_t SCENE_VERSION = 2;
+    const uint64_t SCENE_ALIGNMENT = 16;
+
+    struct SceneHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t curveCount;
+        uint32_t reserved;
+        uint64_t pointCount;
+        // byte offsets from the start of the file
+        uint64_t typesOffset;
+        uint64_t offsetsOffset;
+        uint64_t pointsOffset;
+    };
+
+    // maps the file and uses its control points without copying them
+    bool loadScene(const std::string& path, Scene& scene);
+    // writes next to path and renames over it, so a scene that is mapped from path stays intact
+    bool saveScene(const std::string& path, const Scene& scene);
+}
@@ -0,0 +1,313 @@
+#include "soft_raster.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CURVES_RASTER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace curves
+{
+    // same as stroke.vert
+    const float RASTER_MITER_LIMIT = 4.0f;
+    // below this many tiles a single thread is faster than starting more
+    const int MIN_TILES_PER_THREAD = 4;
+
+    namespace
+    {
+        void direction(const float* a, const float* b, float* out)
+        {
+            float dx = b[0] - a[0], dy = b[1] - a[1];
+            float length = std::sqrt(dx * dx + dy * dy);
+            out[0] = length > 1e-6f ? dx / length : 1.0f;
+            out[1] = length > 1e-6f ? dy / length : 0.0f;
+        }
+
+        // corner of the quad like stroke.vert, side is -1 or 1
+        void corner(const float* point, const float* dir, const float* neighbourDir, bool joined,
+            float side, float along, float extent, float* out)
+        {
+            float normalX = -dir[1], normalY = dir[0];
+            if (!joined)
+            {
+                out[0] = point[0] + extent * (side * normalX + along * dir[0]);
+                out[1] = point[1] + extent * (side * normalY + along * dir[1]);
+                return;
+            }
+            // the quads of two segments meet on the bisector of their normals
+            float miterX = normalX - neighbourDir[1], miterY = normalY + neighbourDir[0];
+            float length = std::sqrt(miterX * miterX + miterY * miterY);
+            if (length > 1e-6f)
+            {
+                miterX /= length;
+                miterY /= length;
+            }
+            else
+            {
+                miterX = normalX;
+                miterY = normalY;
+            }
+            float scale = std::min(1.0f / std::max(miterX * normalX + miterY * normalY, 1e-3f), RASTER_MITER_LIMIT);
+            out[0] = point[0] + side * extent * scale * miterX;
+            out[1] = point[1] + side * extent * scale * miterY;
+        }
+
+        // edges of a triangle facing inwards, a degenerate one gets edges nothing is inside of
+        void triangleEdges(const float* a, const float* b, const float* c, float edges[3][3])
+        {
+            const float* corners[3] = { a, b, c };
+            float area = (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+            float sign = area < 0.0f ? -1.0f : 1.0f;
+            for (int e = 0; e < 3; e++)
+            {
+                const float* from = corners[e];
+                const float* to = corners[(e + 1) % 3];
+                if (area == 0.0f)
+                {
+                    edges[e][0] = edges[e][1] = 0.0f;
+                    edges[e][2] = -1.0f;
+                    continue;
+                }
+                // (to - from) x (p - from)
+                edges[e][0] = -sign * (to[1] - from[1]);
+                edges[e][1] = sign * (to[0] - from[0]);
+                edges[e][2] = -(edges[e][0] * from[0] + edges[e][1] * from[1]);
+            }
+        }
+    }
+
+    SoftRasterizer::SoftRasterizer()
+    {
+        threads = 0;
+        width = height = 0;
+        tilesX = tilesY = 0;
+    }
+
+    void SoftRasterizer::set_thread_count(int threads)
+    {
+        this->threads = std::max(threads, 0);
+    }
+
+    void SoftRasterizer::render(const float* coords, const DrawList& drawList, const float* projection,
+        int width, int height, const RasterStyle& style, std::vector<unsigned char>& rgba)
+    {
+        this->width = std::max(width, 0);
+        this->height = std::max(height, 0);
+        rgba.resize((size_t)this->width * this->height * 4);
+        if (rgba.empty()) return;
+
+        // to window coordinates like toWindow in the shaders
+        const std::vector<uint32_t>& indices = drawList.get_indices();
+        uint32_t vertexCount = 0;
+        for (uint32_t index : indices)
+            if (index != DrawList::RESTART_INDEX) vertexCount = std::max(vertexCount, index + 1);
+        window.resize(2 * vertexCount);
+        for (uint32_t i = 0; i < vertexCount; i++)
+        {
+            float x = coords[2 * i], y = coords[2 * i + 1];
+            float clipX = projection[0] * x + projection[4] * y + projection[12];
+            float clipY = projection[1] * x + projection[5] * y + projection[13];
+            window[2 * i] = (clipX * 0.5f + 0.5f) * width;
+            window[2 * i + 1] = (clipY * 0.5f + 0.5f) * height;
+        }
+
+        // a segment where a strip steps from vertex i to i + 1, as in CurveRenderer::build_segment_flags
+        segments.clear();
+        const uint32_t R = DrawList::RESTART_INDEX;
+        for (size_t k = 0; k + 1 < indices.size(); k++)
+        {
+            uint32_t i = indices[k];
+            if (i == R || indices[k + 1] != i + 1) continue;
+            bool joinedPrev = k > 0 && indices[k - 1] == i - 1;
+            bool joinedNext = k + 2 < indices.size() && indices[k + 2] == i + 2;
+            add_segment(&window[2 * (joinedPrev ? i - 1 : i)], &window[2 * i], &window[2 * (i + 1)],
+                &window[2 * (joinedNext ? i + 2 : i + 1)], joinedPrev, joinedNext, style.halfWidth);
+        }
+        bin_segments();
+
+        int tileCount = tilesX * tilesY;
+        int workers = threads > 0 ? threads : (int)std::max(1u, std::thread::hardware_concurrency());
+        workers = std::max(1, std::min(workers, tileCount / MIN_TILES_PER_THREAD));
+        std::atomic<int> nextTile(0);
+        auto work = [&]()
+        {
+            for (int tile = nextTile++; tile < tileCount; tile = nextTile++)
+                render_tile(tile, style, rgba.data());
+        };
+        std::vector<std::thread> pool;
+        for (int worker = 1; worker < workers; worker++)
+            pool.push_back(std::thread(work));
+        work();
+        for (std::thread& thread : pool)
+            thread.join();
+    }
+
+    void SoftRasterizer::add_segment(const float* prev, const float* start, const float* end, const float* next,
+        bool joinedPrev, bool joinedNext, float halfWidth)
+    {
+        Segment segment;
+        float dir[2], prevDir[2], nextDir[2];
+        direction(start, end, dir);
+        direction(prev, start, prevDir);
+        direction(end, next, nextDir);
+        // one extra pixel for the anti-aliased edge
+        float extent = halfWidth + 1.0f;
+        float quad[4][2];
+        corner(start, dir, prevDir, joinedPrev, -1.0f, -1.0f, extent, quad[0]);
+        corner(start, dir, prevDir, joinedPrev, 1.0f, -1.0f, extent, quad[1]);
+        corner(end, dir, nextDir, joinedNext, -1.0f, 1.0f, extent, quad[2]);
+        corner(end, dir, nextDir, joinedNext, 1.0f, 1.0f, extent, quad[3]);
+        // the triangle strip 0 1 2 3
+        triangleEdges(quad[0], quad[1], quad[2], segment.edges[0]);
+        triangleEdges(quad[2], quad[1], quad[3], segment.edges[1]);
+
+        float minX = quad[0][0], maxX = quad[0][0], minY = quad[0][1], maxY = quad[0][1];
+        for (int c = 1; c < 4; c++)
+        {
+            minX = std::min(minX, quad[c][0]);
+            maxX = std::max(maxX, quad[c][0]);
+            minY = std::min(minY, quad[c][1]);
+            maxY = std::max(maxY, quad[c][1]);
+        }
+        // pixel centers are at + 0.5, NaN vertices fail every comparison and are dropped
+        if (!(maxX >= 0.0f && maxY >= 0.0f && minX <= width && minY <= height)) return;
+        segment.minX = std::max(0, (int)std::floor(minX));
+        segment.minY = std::max(0, (int)std::floor(minY));
+        segment.maxX = std::min(width - 1, (int)std::floor(maxX));
+        segment.maxY = std::min(height - 1, (int)std::floor(maxY));
+
+        segment.startX = start[0];
+        segment.startY = start[1];
+        segment.dirX = end[0] - start[0];
+        segment.dirY = end[1] - start[1];
+        float length2 = segment.dirX * segment.dirX + segment.dirY * segment.dirY;
+        segment.invLength2 = length2 > 0.0f ? 1.0f / length2 : 0.0f;
+        // joined ends are measured against the infinite line, free ones get round caps
+        segment.tMin = joinedPrev ? -std::numeric_limits<float>::max() : 0.0f;
+        segment.tMax = joinedNext ? std::numeric_limits<float>::max() : 1.0f;
+        segments.push_back(segment);
+    }
+
+    void SoftRasterizer::bin_segments()
+    {
+        tilesX = (width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+        tilesY = (height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+        // counted first, so every tile's list is one run of tileSegments
+        tileStarts.assign(tilesX * tilesY + 1, 0);
+        for (const Segment& segment : segments)
+            for (int ty = segment.minY / RASTER_TILE_SIZE; ty <= segment.maxY / RASTER_TILE_SIZE; ty++)
+                for (int tx = segment.minX / RASTER_TILE_SIZE; tx <= segment.maxX / RASTER_TILE_SIZE; tx++)
+                    tileStarts[ty * tilesX + tx + 1]++;
+        for (size_t t = 1; t < tileStarts.size(); t++)
+            tileStarts[t] += tileStarts[t - 1];
+        tileSegments.resize(tileStarts.back());
+        std::vector<int> fill(tileStarts.begin(), tileStarts.end() - 1);
+        for (size_t s = 0; s < segments.size(); s++)
+        {
+            const Segment& segment = segments[s];
+            for (int ty = segment.minY / RASTER_TILE_SIZE; ty <= segment.maxY / RASTER_TILE_SIZE; ty++)
+                for (int tx = segment.minX / RASTER_TILE_SIZE; tx <= segment.maxX / RASTER_TILE_SIZE; tx++)
+                    tileSegments[fill[ty * tilesX + tx]++] = s;
+        }
+    }
+
+    void SoftRasterizer::render_tile(int tile, const RasterStyle& style, unsigned char* rgba) const
+    {
+        int tileX = tile % tilesX * RASTER_TILE_SIZE;
+        int tileY = tile / tilesX * RASTER_TILE_SIZE;
+        int tileWidth = std::min(RASTER_TILE_SIZE, width - tileX);
+        int tileHeight = std::min(RASTER_TILE_SIZE, height - tileY);
+        // how much of the background still shows through every pixel
+        float through[RASTER_TILE_SIZE * RASTER_TILE_SIZE];
+        std::fill(through, through + RASTER_TILE_SIZE * RASTER_TILE_SIZE, 1.0f);
+        float edge = style.halfWidth + 0.5f;
+
+        for (int k = tileStarts[tile]; k < tileStarts[tile + 1]; k++)
+        {
+            const Segment& s = segments[tileSegments[k]];
+            int x0 = std::max(s.minX, tileX) - tileX;
+            int x1 = std::min(s.maxX, tileX + tileWidth - 1) - tileX;
+            int y0 = std::max(s.minY, tileY) - tileY;
+            int y1 = std::min(s.maxY, tileY + tileHeight - 1) - tileY;
+            // whole groups of 4, the pixels past the tile's width are never written out
+            x0 &= ~3;
+            for (int y = y0; y <= y1; y++)
+            {
+                float py = tileY + y + 0.5f;
+                float* row = through + y * RASTER_TILE_SIZE;
+                int x = x0;
+#ifdef CURVES_RASTER_SSE2
+                const __m128 zero = _mm_setzero_ps();
+                const __m128 one = _mm_set1_ps(1.0f);
+                const __m128 lanes = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+                // the parts of the edge functions that don't change along the row
+                __m128 edgeRow[2][3];
+                for (int t = 0; t < 2; t++)
+                    for (int e = 0; e < 3; e++)
+                        edgeRow[t][e] = _mm_set1_ps(s.edges[t][e][1] * py + s.edges[t][e][2]);
+                const __m128 dy = _mm_set1_ps(py - s.startY);
+                for (; x <= x1; x += 4)
+                {
+                    __m128 px = _mm_add_ps(_mm_set1_ps((float)(tileX + x)), lanes);
+                    __m128 inside[2];
+                    for (int t = 0; t < 2; t++)
+                    {
+                        __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s.edges[t][0][0]), px), edgeRow[t][0]);
+                        __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s.edges[t][1][0]), px), edgeRow[t][1]);
+                        __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s.edges[t][2][0]), px), edgeRow[t][2]);
+                        inside[t] = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                    }
+                    __m128 dx = _mm_sub_ps(px, _mm_set1_ps(s.startX));
+                    __m128 t = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_set1_ps(s.dirX)), _mm_mul_ps(dy, _mm_set1_ps(s.dirY))),
+                        _mm_set1_ps(s.invLength2));
+                    t = _mm_min_ps(_mm_max_ps(t, _mm_set1_ps(s.tMin)), _mm_set1_ps(s.tMax));
+                    __m128 ex = _mm_sub_ps(dx, _mm_mul_ps(t, _mm_set1_ps(s.dirX)));
+                    __m128 ey = _mm_sub_ps(dy, _mm_mul_ps(t, _mm_set1_ps(s.dirY)));
+                    __m128 d = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)));
+                    __m128 coverage = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(edge), d), zero), one);
+                    coverage = _mm_and_ps(coverage, _mm_or_ps(inside[0], inside[1]));
+                    _mm_storeu_ps(row + x, _mm_mul_ps(_mm_loadu_ps(row + x), _mm_sub_ps(one, coverage)));
+                }
+#else
+                for (; x <= x1; x++)
+                {
+                    float px = tileX + x + 0.5f;
+                    bool inside[2];
+                    for (int t = 0; t < 2; t++)
+                    {
+                        const float (*e)[3] = s.edges[t];
+                        inside[t] = e[0][0] * px + e[0][1] * py + e[0][2] >= 0.0f
+                            && e[1][0] * px + e[1][1] * py + e[1][2] >= 0.0f
+                            && e[2][0] * px + e[2][1] * py + e[2][2] >= 0.0f;
+                    }
+                    if (!inside[0] && !inside[1]) continue;
+                    float dx = px - s.startX, dy = py - s.startY;
+                    float t = (dx * s.dirX + dy * s.dirY) * s.invLength2;
+                    t = std::min(std::max(t, s.tMin), s.tMax);
+                    float ex = dx - t * s.dirX, ey = dy - t * s.dirY;
+                    float coverage = std::min(std::max(edge - std::sqrt(ex * ex + ey * ey), 0.0f), 1.0f);
+                    row[x] *= 1.0f - coverage;
+                }
+#endif
+            }
+        }
+
+        // every channel, alpha too, is color over background by the coverage
+        for (int y = 0; y < tileHeight; y++)
+        {
+            unsigned char* out = rgba + ((size_t)(tileY + y) * width + tileX) * 4;
+            const float* row = through + y * RASTER_TILE_SIZE;
+            for (int x = 0; x < tileWidth; x++)
+                for (int c = 0; c < 4; c++)
+                {
+                    float value = style.color[c] + (style.background[c] - style.color[c]) * row[x];
+                    out[4 * x + c] = (unsigned char)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+                }
+        }
+    }
+}
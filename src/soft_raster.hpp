@@ -0,0 +1,65 @@
+#pragma once
+
+#include "draw_list.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace curves
+{
+    // side of the square tiles the image is split into, a multiple of 4 for the SIMD rows
+    const int RASTER_TILE_SIZE = 64;
+
+    struct RasterStyle
+    {
+        // in pixels, CurveRenderer strokes are 1.5
+        float halfWidth;
+        // RGBA in [0 : 1]
+        float color[4];
+        float background[4];
+    };
+
+    // Draws the strips of a draw list without any GL, the way CurveRenderer does in LineMode::Stroke:
+    // every segment is the same quad (mitered where strips continue) with the same distance-based
+    // coverage. All strips have one color, so blending them is order independent and every tile can
+    // keep how much of the background shows through (the product of 1 - coverage) and be
+    // done by another thread. The coverage is computed for 4 pixels at a time with SSE2 where it's there.
+    class SoftRasterizer
+    {
+    public:
+        SoftRasterizer();
+        // 0 uses one thread per core
+        void set_thread_count(int threads);
+        // coords are the x, y pairs drawList indexes, projection the column-major matrix the GL path
+        // gets. rgba gets width * height pixels, rows bottom to top like glReadPixels gives them.
+        void render(const float* coords, const DrawList& drawList, const float* projection,
+            int width, int height, const RasterStyle& style, std::vector<unsigned char>& rgba);
+    private:
+        // one stroke quad in window coordinates, drawn as two triangles like the GL triangle strip
+        struct Segment
+        {
+            float startX, startY, dirX, dirY;
+            // 1 / squared length, 0 for a point
+            float invLength2;
+            // where the nearest point on the segment may go, unbounded on joined ends
+            float tMin, tMax;
+            // a x + b y + c >= 0 inside, three edges per triangle
+            float edges[2][3][3];
+            // pixels the quad can touch, clipped to the image
+            int minX, minY, maxX, maxY;
+        };
+        void add_segment(const float* prev, const float* start, const float* end, const float* next,
+            bool joinedPrev, bool joinedNext, float halfWidth);
+        // sorts the segments into the tiles they touch
+        void bin_segments();
+        void render_tile(int tile, const RasterStyle& style, unsigned char* rgba) const;
+        int threads;
+        int width, height;
+        int tilesX, tilesY;
+        std::vector<Segment> segments;
+        // segments of tile t are tileSegments[tileStarts[t] : tileStarts[t + 1]]
+        std::vector<int> tileStarts;
+        std::vector<int> tileSegments;
+        std::vector<float> window;
+    };
+}
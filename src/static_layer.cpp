@@ -0,0 +1,101 @@
+#include "static_layer.hpp"
+
+#include <iostream>
+
+namespace curves
+{
+    StaticLayer::StaticLayer()
+    {
+        shader = 0;
+        layerLoc = -1;
+        framebuffer = texture = emptyVAO = 0;
+        width = height = 0;
+        valid = false;
+        previousFramebuffer = 0;
+    }
+
+    bool StaticLayer::init(GLuint compositeShader)
+    {
+        shader = compositeShader;
+        layerLoc = glGetUniformLocation(shader, "layer");
+        if (layerLoc < 0)
+        {
+            std::cerr << "ERROR::LAYER::MISSING_UNIFORM" << std::endl;
+            return false;
+        }
+        glGenFramebuffers(1, &framebuffer);
+        glGenTextures(1, &texture);
+        glGenVertexArrays(1, &emptyVAO);
+        return true;
+    }
+
+    void StaticLayer::destroy()
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteTextures(1, &texture);
+        glDeleteVertexArrays(1, &emptyVAO);
+        framebuffer = texture = emptyVAO = 0;
+        width = height = 0;
+        valid = false;
+    }
+
+    bool StaticLayer::is_valid(int width, int height) const
+    {
+        return valid && this->width == width && this->height == height;
+    }
+
+    void StaticLayer::invalidate()
+    {
+        valid = false;
+    }
+
+    bool StaticLayer::resize(int width, int height)
+    {
+        this->width = width;
+        this->height = height;
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        // texelFetch doesn't filter, but an incomplete mip chain would still make the texture unusable
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        bool complete = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousFramebuffer);
+        if (!complete)
+        {
+            std::cerr << "ERROR::LAYER::INCOMPLETE_FRAMEBUFFER" << std::endl;
+            this->width = this->height = 0;
+        }
+        return complete;
+    }
+
+    bool StaticLayer::begin_update(int width, int height)
+    {
+        valid = false;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        if ((width != this->width || height != this->height) && !resize(width, height)) return false;
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+        glClear(GL_COLOR_BUFFER_BIT);
+        return true;
+    }
+
+    void StaticLayer::end_update()
+    {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousFramebuffer);
+        valid = true;
+    }
+
+    void StaticLayer::composite()
+    {
+        glUseProgram(shader);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glUniform1i(layerLoc, 0);
+        glBindVertexArray(emptyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+}
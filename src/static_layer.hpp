@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glad/glad.h>
+
+namespace curves
+{
+    // A picture rendered once into a texture and then pasted over the framebuffer every frame,
+    // for the parts of the drawing that didn't change.
+    class StaticLayer
+    {
+    public:
+        StaticLayer();
+        // compositeShader draws a triangle over the viewport and reads the texture "layer"
+        bool init(GLuint compositeShader);
+        void destroy();
+        // whether the picture is there and was made at this size
+        bool is_valid(int width, int height) const;
+        void invalidate();
+        // redirects drawing into the layer, cleared with the current clear color,
+        // returns false (and draws nowhere else) if the framebuffer can't be made
+        bool begin_update(int width, int height);
+        // back to the framebuffer that was bound before begin_update
+        void end_update();
+        // covers the viewport with the picture, it replaces what was there
+        void composite();
+    private:
+        // (re)creates the texture for another size
+        bool resize(int width, int height);
+        GLuint shader;
+        GLint layerLoc;
+        GLuint framebuffer, texture;
+        // attribute-less, the composite triangle comes from gl_VertexID
+        GLuint emptyVAO;
+        int width, height;
+        bool valid;
+        GLint previousFramebuffer;
+    };
+}
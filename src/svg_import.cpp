@@ -0,0 +1,414 @@
+#include "svg_import.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace curves
+{
+    // drawings are fitted into [-SVG_FIT_EXTENT : SVG_FIT_EXTENT]
+    const float SVG_FIT_EXTENT = 0.9f;
+
+    namespace
+    {
+        const double PI = 3.14159265358979323846;
+
+        bool isSeparator(char c)
+        {
+            return c == ' ' || c == ',' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+        }
+
+        bool isDigit(char c)
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        void skipSeparators(const char*& p, const char* end)
+        {
+            while (p < end && isSeparator(*p)) p++;
+        }
+
+        // parses a number straight out of the mapped file, no terminator needed
+        bool readNumber(const char*& p, const char* end, float& value)
+        {
+            skipSeparators(p, end);
+            const char* start = p;
+            bool negative = false;
+            if (p < end && (*p == '+' || *p == '-'))
+            {
+                negative = *p == '-';
+                p++;
+            }
+            double mantissa = 0.0;
+            int digits = 0;
+            int exponent = 0;
+            while (p < end && isDigit(*p))
+            {
+                mantissa = mantissa * 10.0 + (*p++ - '0');
+                digits++;
+            }
+            if (p < end && *p == '.')
+            {
+                p++;
+                while (p < end && isDigit(*p))
+                {
+                    mantissa = mantissa * 10.0 + (*p++ - '0');
+                    exponent--;
+                    digits++;
+                }
+            }
+            if (digits == 0)
+            {
+                p = start;
+                return false;
+            }
+            if (p < end && (*p == 'e' || *p == 'E'))
+            {
+                const char* e = p + 1;
+                bool negativeExponent = false;
+                if (e < end && (*e == '+' || *e == '-'))
+                {
+                    negativeExponent = *e == '-';
+                    e++;
+                }
+                if (e < end && isDigit(*e))
+                {
+                    int value = 0;
+                    while (e < end && isDigit(*e))
+                        value = std::min(value * 10 + (*e++ - '0'), 1000);
+                    exponent += negativeExponent ? -value : value;
+                    p = e;
+                }
+            }
+            double result = exponent == 0 ? mantissa : mantissa * std::pow(10.0, exponent);
+            value = (float)(negative ? -result : result);
+            return true;
+        }
+
+        // arc flags may be written without any separator ("a1 1 0 00 1 1")
+        bool readFlag(const char*& p, const char* end, bool& flag)
+        {
+            skipSeparators(p, end);
+            if (p >= end || (*p != '0' && *p != '1')) return false;
+            flag = *p++ == '1';
+            return true;
+        }
+
+        bool readNumbers(const char*& p, const char* end, float* values, int count)
+        {
+            for (int i = 0; i < count; i++)
+                if (!readNumber(p, end, values[i])) return false;
+            return true;
+        }
+
+        // collects one subpath at a time as a chain of cubics
+        class PathBuilder
+        {
+        public:
+            explicit PathBuilder(Scene& scene) : scene(scene)
+            {
+                x = y = startX = startY = 0.0f;
+            }
+
+            void move_to(float px, float py)
+            {
+                flush();
+                x = startX = px;
+                y = startY = py;
+            }
+
+            void line_to(float px, float py)
+            {
+                cubic_to(x + (px - x) / 3.0f, y + (py - y) / 3.0f, px + (x - px) / 3.0f, py + (y - py) / 3.0f, px, py);
+            }
+
+            void quad_to(float qx, float qy, float px, float py)
+            {
+                // degree elevation is exact
+                cubic_to(x + 2.0f / 3.0f * (qx - x), y + 2.0f / 3.0f * (qy - y),
+                    px + 2.0f / 3.0f * (qx - px), py + 2.0f / 3.0f * (qy - py), px, py);
+            }
+
+            void cubic_to(float x1, float y1, float x2, float y2, float px, float py)
+            {
+                if (current.empty())
+                {
+                    current.push_back(x);
+                    current.push_back(y);
+                }
+                float segment[6] = { x1, y1, x2, y2, px, py };
+                current.insert(current.end(), segment, segment + 6);
+                x = px;
+                y = py;
+            }
+
+            void arc_to(float rx, float ry, float rotation, bool largeArc, bool sweep, float px, float py)
+            {
+                // endpoint to center parameterization, SVG 1.1 appendix F.6.5
+                rx = std::fabs(rx);
+                ry = std::fabs(ry);
+                if (rx == 0.0f || ry == 0.0f || (px == x && py == y))
+                {
+                    if (px != x || py != y) line_to(px, py);
+                    return;
+                }
+                double phi = rotation * PI / 180.0;
+                double cosPhi = std::cos(phi), sinPhi = std::sin(phi);
+                double dx = (x - px) / 2.0, dy = (y - py) / 2.0;
+                double x1 = cosPhi * dx + sinPhi * dy;
+                double y1 = -sinPhi * dx + cosPhi * dy;
+                double rxs = (double)rx * rx, rys = (double)ry * ry;
+                // radii that are too small get scaled up until the arc fits
+                double lambda = x1 * x1 / rxs + y1 * y1 / rys;
+                if (lambda > 1.0)
+                {
+                    rx *= std::sqrt(lambda);
+                    ry *= std::sqrt(lambda);
+                    rxs = (double)rx * rx;
+                    rys = (double)ry * ry;
+                }
+                double numerator = rxs * rys - rxs * y1 * y1 - rys * x1 * x1;
+                double denominator = rxs * y1 * y1 + rys * x1 * x1;
+                double root = std::sqrt(std::max(numerator / denominator, 0.0));
+                if (largeArc == sweep) root = -root;
+                double cx1 = root * rx * y1 / ry;
+                double cy1 = -root * ry * x1 / rx;
+                double cx = cosPhi * cx1 - sinPhi * cy1 + (x + px) / 2.0;
+                double cy = sinPhi * cx1 + cosPhi * cy1 + (y + py) / 2.0;
+                double theta = std::atan2((y1 - cy1) / ry, (x1 - cx1) / rx);
+                double delta = std::atan2((-y1 - cy1) / ry, (-x1 - cx1) / rx) - theta;
+                if (sweep && delta < 0) delta += 2 * PI;
+                if (!sweep && delta > 0) delta -= 2 * PI;
+                // one cubic per quarter turn at most
+                int pieces = std::max((int)std::ceil(std::fabs(delta) / (PI / 2) - 1e-9), 1);
+                double step = delta / pieces;
+                double k = 4.0 / 3.0 * std::tan(step / 4.0);
+                for (int i = 0; i < pieces; i++)
+                {
+                    double a0 = theta + i * step, a1 = a0 + step;
+                    double e0x = std::cos(a0), e0y = std::sin(a0);
+                    double e1x = std::cos(a1), e1y = std::sin(a1);
+                    // unit circle control points, then scaled, rotated and moved
+                    double ux[3] = { e0x - k * e0y, e1x + k * e1y, e1x };
+                    double uy[3] = { e0y + k * e0x, e1y - k * e1x, e1y };
+                    float out[6];
+                    for (int j = 0; j < 3; j++)
+                    {
+                        out[2 * j] = (float)(cx + cosPhi * rx * ux[j] - sinPhi * ry * uy[j]);
+                        out[2 * j + 1] = (float)(cy + sinPhi * rx * ux[j] + cosPhi * ry * uy[j]);
+                    }
+                    // land exactly on the requested end point
+                    if (i == pieces - 1)
+                    {
+                        out[4] = px;
+                        out[5] = py;
+                    }
+                    cubic_to(out[0], out[1], out[2], out[3], out[4], out[5]);
+                }
+            }
+
+            void close()
+            {
+                if (x != startX || y != startY) line_to(startX, startY);
+                flush();
+                // the next subpath starts where this one was closed
+                x = startX;
+                y = startY;
+            }
+
+            void flush()
+            {
+                if (current.size() >= 8)
+                    scene.add_curve(CurveType::CubicBezier, current.data(), current.size() / 2);
+                // keeps its capacity for the next subpath
+                current.clear();
+            }
+
+            float x, y;
+            float startX, startY;
+        private:
+            Scene& scene;
+            std::vector<float> current;
+        };
+
+        void parsePathData(const char* p, const char* end, PathBuilder& path)
+        {
+            // every path element starts at the origin
+            path.move_to(0.0f, 0.0f);
+            char command = 0;
+            // second control point of the last cubic / control point of the last quadratic, for S and T
+            float cubicX = 0, cubicY = 0, quadX = 0, quadY = 0;
+            char previous = 0;
+            while (true)
+            {
+                skipSeparators(p, end);
+                if (p >= end) break;
+                if ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z'))
+                    command = *p++;
+                else if (command == 0)
+                    break;
+                bool relative = command >= 'a';
+                float ox = relative ? path.x : 0.0f;
+                float oy = relative ? path.y : 0.0f;
+                float v[7];
+                bool ok = true;
+                switch (command)
+                {
+                case 'M': case 'm':
+                    if (!(ok = readNumbers(p, end, v, 2))) break;
+                    path.move_to(ox + v[0], oy + v[1]);
+                    // pairs after the first one are implicit line commands
+                    command = relative ? 'l' : 'L';
+                    break;
+                case 'L': case 'l':
+                    if (!(ok = readNumbers(p, end, v, 2))) break;
+                    path.line_to(ox + v[0], oy + v[1]);
+                    break;
+                case 'H': case 'h':
+                    if (!(ok = readNumbers(p, end, v, 1))) break;
+                    path.line_to(ox + v[0], path.y);
+                    break;
+                case 'V': case 'v':
+                    if (!(ok = readNumbers(p, end, v, 1))) break;
+                    path.line_to(path.x, oy + v[0]);
+                    break;
+                case 'C': case 'c':
+                    if (!(ok = readNumbers(p, end, v, 6))) break;
+                    cubicX = ox + v[2];
+                    cubicY = oy + v[3];
+                    path.cubic_to(ox + v[0], oy + v[1], cubicX, cubicY, ox + v[4], oy + v[5]);
+                    break;
+                case 'S': case 's':
+                {
+                    if (!(ok = readNumbers(p, end, v, 4))) break;
+                    // first control point mirrors the last one of the previous cubic
+                    bool smooth = previous == 'C' || previous == 'S';
+                    float x1 = smooth ? 2 * path.x - cubicX : path.x;
+                    float y1 = smooth ? 2 * path.y - cubicY : path.y;
+                    cubicX = ox + v[0];
+                    cubicY = oy + v[1];
+                    path.cubic_to(x1, y1, cubicX, cubicY, ox + v[2], oy + v[3]);
+                    break;
+                }
+                case 'Q': case 'q':
+                    if (!(ok = readNumbers(p, end, v, 4))) break;
+                    quadX = ox + v[0];
+                    quadY = oy + v[1];
+                    path.quad_to(quadX, quadY, ox + v[2], oy + v[3]);
+                    break;
+                case 'T': case 't':
+                {
+                    if (!(ok = readNumbers(p, end, v, 2))) break;
+                    bool smooth = previous == 'Q' || previous == 'T';
+                    quadX = smooth ? 2 * path.x - quadX : path.x;
+                    quadY = smooth ? 2 * path.y - quadY : path.y;
+                    path.quad_to(quadX, quadY, ox + v[0], oy + v[1]);
+                    break;
+                }
+                case 'A': case 'a':
+                {
+                    bool largeArc, sweep;
+                    ok = readNumbers(p, end, v, 3) && readFlag(p, end, largeArc) && readFlag(p, end, sweep)
+                        && readNumbers(p, end, v + 3, 2);
+                    if (!ok) break;
+                    path.arc_to(v[0], v[1], v[2], largeArc, sweep, ox + v[3], oy + v[4]);
+                    break;
+                }
+                case 'Z': case 'z':
+                    path.close();
+                    // Z takes no numbers, anything that follows needs its own command
+                    command = 0;
+                    break;
+                default:
+                    ok = false;
+                    break;
+                }
+                // malformed data: keep what was read so far, like browsers do
+                if (!ok) break;
+                previous = command >= 'a' ? command - 'a' + 'A' : command;
+            }
+            path.flush();
+        }
+
+        // finds the next "<path" tag, returns end if there is none
+        const char* findPathTag(const char* p, const char* end)
+        {
+            while (p < end)
+            {
+                const char* open = (const char*)std::memchr(p, '<', end - p);
+                if (open == NULL) return end;
+                if (end - open > 5 && std::memcmp(open + 1, "path", 4) == 0
+                    && (isSeparator(open[5]) || open[5] == '/' || open[5] == '>'))
+                    return open + 5;
+                p = open + 1;
+            }
+            return end;
+        }
+    }
+
+    bool importSvg(const std::string& path, Scene& scene)
+    {
+        MappedFile file;
+        if (!file.open(path))
+        {
+            std::cerr << "ERROR::SVG::FILE_NOT_SUCCESFULLY_MAPPED: " << path << std::endl;
+            return false;
+        }
+        const char* p = (const char*)file.data();
+        const char* end = p + file.size();
+        size_t firstPoint = scene.point_count();
+        PathBuilder builder(scene);
+        while ((p = findPathTag(p, end)) < end)
+        {
+            // walk the attributes of the tag, only d is of interest
+            while (p < end)
+            {
+                while (p < end && (isSeparator(*p) || *p == '/')) p++;
+                if (p >= end || *p == '>') break;
+                const char* name = p;
+                while (p < end && *p != '=' && *p != '>' && !isSeparator(*p)) p++;
+                size_t nameLength = p - name;
+                skipSeparators(p, end);
+                if (p >= end || *p != '=') continue;
+                p++;
+                skipSeparators(p, end);
+                if (p >= end || (*p != '"' && *p != '\'')) continue;
+                char quote = *p++;
+                const char* valueEnd = (const char*)std::memchr(p, quote, end - p);
+                if (valueEnd == NULL) valueEnd = end;
+                if (nameLength == 1 && *name == 'd')
+                    parsePathData(p, valueEnd, builder);
+                p = valueEnd + (valueEnd < end ? 1 : 0);
+            }
+        }
+        size_t pointCount = scene.point_count() - firstPoint;
+        if (pointCount == 0)
+        {
+            std::cerr << "ERROR::SVG::NO_PATHS_FOUND: " << path << std::endl;
+            return false;
+        }
+
+        // flip and fit the imported points
+        float* points = scene.points().data() + 2 * firstPoint;
+        float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+        for (size_t i = 0; i < pointCount; i++)
+        {
+            minX = std::min(minX, points[2 * i]);
+            maxX = std::max(maxX, points[2 * i]);
+            minY = std::min(minY, points[2 * i + 1]);
+            maxY = std::max(maxY, points[2 * i + 1]);
+        }
+        float extent = std::max(maxX - minX, maxY - minY);
+        float scale = extent > 0.0f ? 2.0f * SVG_FIT_EXTENT / extent : 1.0f;
+        float centerX = 0.5f * (minX + maxX);
+        float centerY = 0.5f * (minY + maxY);
+        for (size_t i = 0; i < pointCount; i++)
+        {
+            points[2 * i] = (points[2 * i] - centerX) * scale;
+            points[2 * i + 1] = (centerY - points[2 * i + 1]) * scale;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "scene.hpp"
+
+#include <string>
+
+namespace curves
+{
+    // Appends every <path d="..."> of an SVG file to the scene, one CubicBezier curve per subpath.
+    // Lines and quadratics are raised to cubics, arcs are split into cubics of at most 90 degrees.
+    // Transforms and styles are ignored. The drawing is flipped (SVG y points down), centered and
+    // scaled so its longer side spans [-0.9 : 0.9] (SVG_FIT_EXTENT), a margin inside the default view.
+    bool importSvg(const std::string& path, Scene& scene);
+}
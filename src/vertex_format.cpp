@@ -0,0 +1,47 @@
+#include "vertex_format.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace curves
+{
+    // quantized values stay in [-QUANTIZED_MAX : QUANTIZED_MAX], symmetric around the box center
+    const float QUANTIZED_MAX = 32767.0f;
+
+    bool quantizeVertices(const std::vector<float>& coords, float maxError, std::vector<int16_t>& out, Dequantize& transform)
+    {
+        float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+        for (size_t i = 0; i + 1 < coords.size(); i += 2)
+        {
+            minX = std::min(minX, coords[i]);
+            maxX = std::max(maxX, coords[i]);
+            minY = std::min(minY, coords[i + 1]);
+            maxY = std::max(maxY, coords[i + 1]);
+        }
+        if (coords.empty()) minX = minY = maxX = maxY = 0.0f;
+        // half extents, never 0 so the division below stays finite
+        float halfX = std::max(0.5f * (maxX - minX), FLT_MIN);
+        float halfY = std::max(0.5f * (maxY - minY), FLT_MIN);
+        // rounding moves a vertex by at most half a step along each axis
+        float errorX = 0.5f * halfX / QUANTIZED_MAX;
+        float errorY = 0.5f * halfY / QUANTIZED_MAX;
+        if (std::sqrt(errorX * errorX + errorY * errorY) > maxError) return false;
+
+        transform.offsetX = 0.5f * (minX + maxX);
+        transform.offsetY = 0.5f * (minY + maxY);
+        transform.scaleX = halfX / QUANTIZED_MAX;
+        transform.scaleY = halfY / QUANTIZED_MAX;
+        float toX = QUANTIZED_MAX / halfX;
+        float toY = QUANTIZED_MAX / halfY;
+        out.resize(coords.size());
+        for (size_t i = 0; i + 1 < coords.size(); i += 2)
+        {
+            float x = (coords[i] - transform.offsetX) * toX;
+            float y = (coords[i + 1] - transform.offsetY) * toY;
+            out[i] = (int16_t)std::lrint(std::min(std::max(x, -QUANTIZED_MAX), QUANTIZED_MAX));
+            out[i + 1] = (int16_t)std::lrint(std::min(std::max(y, -QUANTIZED_MAX), QUANTIZED_MAX));
+        }
+        return true;
+    }
+}
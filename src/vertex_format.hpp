@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace curves
+{
+    // maps 16-bit positions back to world space: world = offset + scale * value. The shorts are read
+    // as plain integers, not normalized, because GL 3.3 and 4.2+ decode normalized shorts differently.
+    struct Dequantize
+    {
+        float offsetX, offsetY;
+        float scaleX, scaleY;
+    };
+
+    // identity transform for the float vertex path
+    const Dequantize FLOAT_VERTICES = { 0.0f, 0.0f, 1.0f, 1.0f };
+
+    // Packs x, y pairs into signed 16-bit values relative to their bounding box.
+    // Fails (and leaves out untouched) if the rounding error could exceed maxError world units.
+    bool quantizeVertices(const std::vector<float>& coords, float maxError, std::vector<int16_t>& out, Dequantize& transform);
+}
@@ -0,0 +1,146 @@
+// Refreshing a drawing that didn't change must get by with the memory the first frames left behind,
+// up to and including working out what goes to the GPU. Built with DEBUG, so allocationCount() counts.
+//
+// usage: steady_frames_test <directory with shapes.svg>
+
+#include "alloc_counter.hpp"
+#include "curve_program.hpp"
+#include "dirty_ranges.hpp"
+#include "frame_governor.hpp"
+#include "scene_file.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const int WINDOW_WIDTH = 800;
+    const int WINDOW_HEIGHT = 600;
+    // frames that may still grow the frame arena and the buffers
+    const int WARMUP_FRAMES = 4;
+    const int STEADY_FRAMES = 8;
+
+    // What CurveRenderer::upload does with the vertices, without a GL context: one section per
+    // curve and style, and the static curves in front are kept while the revision stays.
+    class VertexUpload
+    {
+    public:
+        VertexUpload()
+        {
+            revision = 0;
+            uploaded = false;
+        }
+        void update(const curves::CurveProgram& program)
+        {
+            const std::vector<float>& coords = program.get_line_coords();
+            int live = program.live_curve();
+            sections.clear();
+            size_t kept = coords.size() * sizeof(float);
+            for (const curves::DrawRange& range : program.get_draw_list().get_ranges())
+            {
+                uint64_t key = ((uint64_t)(range.curve == live) << 33) | ((uint64_t)range.style << 32) | (uint32_t)range.curve;
+                curves::BufferSection section = { key, range.firstVertex * 2 * sizeof(float), range.vertexCount * 2 * sizeof(float) };
+                sections.push_back(section);
+                if (range.curve == live) kept = std::min(kept, section.offset);
+            }
+            bool same = uploaded && program.layer_revision() == revision;
+            tracker.update(coords.data(), coords.size() * sizeof(float), sections, same ? kept : 0);
+            revision = program.layer_revision();
+            uploaded = true;
+        }
+    private:
+        curves::DirtyRangeTracker tracker;
+        std::vector<curves::BufferSection> sections;
+        unsigned revision;
+        bool uploaded;
+    };
+
+    // Runs frames with every combination of settings and returns whether the ones after the
+    // warmup didn't allocate
+    bool checkScene(const std::string& name, curves::CurveProgram& program)
+    {
+        bool ok = true;
+        program.resize_window(WINDOW_WIDTH, WINDOW_HEIGHT);
+        VertexUpload upload;
+        double time = 0.0;
+        for (int hulls = 0; hulls < 2; hulls++)
+        for (int even = 0; even < 2; even++)
+        for (int level = 0; level < curves::QUALITY_LEVEL_COUNT; level++)
+        {
+            for (int frame = 0; frame < WARMUP_FRAMES + STEADY_FRAMES; frame++)
+            {
+                time += 1.0 / 60.0;
+                size_t before = curves::allocationCount();
+                program.begin_frame();
+                program.update_drag(time);
+                program.set_cubic_hulls(hulls != 0);
+                program.set_even_spacing(even != 0);
+                program.set_quality(curves::QUALITY_LEVELS[level]);
+                program.refresh_line();
+                upload.update(program);
+                size_t allocations = curves::allocationCount() - before;
+                if (frame < WARMUP_FRAMES || allocations == 0) continue;
+                std::cerr << "ERROR::TEST::STEADY_FRAME_ALLOCATED: " << name
+                    << " hulls " << hulls << " even " << even << " level " << level << " frame " << frame
+                    << ": " << allocations << " allocations" << std::endl;
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+    // a scene file with every curve type, NURBS included
+    bool writeMixedScene(const std::string& path)
+    {
+        curves::Scene scene;
+        const float cubic[] = { -0.8f, -0.5f, -0.6f, 0.3f, -0.3f, 0.3f, -0.1f, -0.2f, 0.1f, -0.6f, 0.4f, -0.4f, 0.6f, 0.0f };
+        const float nodes[] = { -0.7f, 0.5f, -0.4f, 0.7f, -0.1f, 0.5f, 0.2f, 0.8f };
+        scene.add_curve(curves::CurveType::CubicBezier, cubic, 7);
+        scene.add_curve(curves::CurveType::Lagrange, nodes, 4);
+        scene.add_curve(curves::CurveType::CatmullRom, cubic, 5);
+        scene.add_curve(curves::CurveType::Centripetal, nodes, 4);
+        scene.add_curve(curves::CurveType::Cardinal, cubic + 4, 5);
+        curves::NurbsData nurbs;
+        nurbs.degree = 3;
+        const float knots[] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.5f, 1.0f, 1.0f, 1.0f, 1.0f };
+        const float weights[] = { 1.0f, 2.0f, 0.5f, 1.0f, 1.0f };
+        nurbs.knots.assign(knots, knots + 9);
+        nurbs.weights.assign(weights, weights + 5);
+        return scene.add_nurbs_curve(cubic + 2, 5, nurbs) && curves::saveScene(path, scene);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: steady_frames_test <directory with shapes.svg>" << std::endl;
+        return 2;
+    }
+    // a release build of alloc_counter.cpp counts nothing and would pass anything
+    size_t before = curves::allocationCount();
+    delete new int(0);
+    if (curves::allocationCount() == before)
+    {
+        std::cerr << "ERROR::TEST::ALLOCATIONS_NOT_COUNTED" << std::endl;
+        return 1;
+    }
+
+    std::string svg = std::string(argv[1]) + "/shapes.svg";
+    // written next to the test, ctest runs it in the build directory
+    std::string mixed = "steady_frames_mixed.oglc";
+    if (!writeMixedScene(mixed)) return 1;
+
+    curves::CurveProgram defaultScene;
+    bool ok = checkScene("default scene", defaultScene);
+    curves::CurveProgram svgScene;
+    if (!svgScene.load_scene(svg)) return 1;
+    ok = checkScene(svg, svgScene) && ok;
+    curves::CurveProgram mixedScene;
+    if (!mixedScene.load_scene(mixed)) return 1;
+    ok = checkScene(mixed, mixedScene) && ok;
+    std::cout << (ok ? "no allocations in steady frames" : "steady frames allocated") << std::endl;
+    return ok ? 0 : 1;
+}